@@ -0,0 +1,665 @@
+//
+// bench: benchmarks of ttyplot internals, and of rendering to a headless screen
+//
+// License: Apache 2.0
+//
+
+// The benchmarks call ttyplot's own (static) functions, so pull in its source.
+#define main ttyplot_main
+#include "ttyplot.c"
+#undef main
+
+const char bench_help[] =
+    "Usage:\n"
+    "  bench [-n records] [-f frames]\n"
+    "  bench -h\n"
+    "\n"
+    "  -h          print this help message and exit\n"
+    "  -n records  number of records or tokens per workload (default: 1000000)\n"
+    "  -f frames   number of frames per rendering mode (default: 2000)\n"
+    "\n"
+    "Prints one line of space-separated key=value pairs per benchmark.\n";
+
+const char bench_optstring[] = "hn:f:";
+
+// Deterministic workloads, indexed by record number.
+enum Workload { WORKLOAD_SINE, WORKLOAD_METRICS, WORKLOAD_RANDOM, NUM_WORKLOADS };
+static const char *workload_names[NUM_WORKLOADS] = {"sine", "metrics", "random"};
+
+// Like `stresstest`: one decimal place, as typically printed by producers.
+static double workload_value(enum Workload w, long long i) {
+    switch (w) {
+        case WORKLOAD_SINE:
+            return round((sin(i * 5 * M_PI / 180) * 5 + 5) * 10) / 10;
+        case WORKLOAD_METRICS:
+            return round((20 + 10 * sin(i / 50.0) + (i % 97 == 0 ? 60 : 0)) * 10) / 10;
+        default:
+            return (double)rand() / RAND_MAX * 200 - 100;
+    }
+}
+
+// Timestamps one second apart, with a few milliseconds of jitter now and then.
+static long long workload_time(long long i) {
+    return 1700000000000LL + i * 1000 + ((i % 10 == 0) ? (i / 10) % 7 : 0);
+}
+
+static void history_reset(void) {
+    for (int i = 0; i < history_num_blocks; i++)
+        free(history_blocks[(history_first_block + i) % history_max_blocks]);
+    free(history_blocks);
+    history_max_blocks = history_budget * 1024LL / sizeof(struct history_block);
+    history_blocks = calloc(history_max_blocks, sizeof(*history_blocks));
+    history_first_block = history_num_blocks = 0;
+    v = 0;
+}
+
+static void bench_history(enum Workload w, long long records) {
+    double *expected = malloc(records * sizeof(double));
+    long long errors = 0;
+
+    srand(1);
+    for (long long i = 0; i < records; i++)
+        expected[i] = workload_value(w, i);
+
+    // Make room for the whole workload: 16 bytes per record is beyond worst case.
+    history_budget = records * 16 / 1024 + 64;
+    history_reset();
+
+    double start = monotonic_now();
+    for (long long i = 0; i < records; i++) {
+        history_append(workload_time(i), &expected[i]);
+        v++;
+    }
+    const double encode_time = monotonic_now() - start;
+
+    size_t bytes = 0;
+    for (int i = 0; i < history_num_blocks; i++)
+        bytes += (history_blocks[i]->bits + 7) / 8;
+
+    struct history_reader reader;
+    long long t, i = history_seek(&reader, 0);
+    double record[MAX_SERIES];
+    start = monotonic_now();
+    while (history_next(&reader, &t, record)) {
+        if (t != workload_time(i) ||
+            memcmp(&record[0], &expected[i], sizeof(double)) != 0)
+            errors++;
+        i++;
+    }
+    const double decode_time = monotonic_now() - start;
+    if (i != records)
+        errors++;
+
+    printf("history workload=%s records=%lld bytes_per_record=%.3f "
+           "encode_ns_per_record=%.1f decode_ns_per_record=%.1f errors=%lld\n",
+           workload_names[w], records, (double)bytes / records,
+           encode_time * 1e9 / records, decode_time * 1e9 / records, errors);
+    free(expected);
+}
+
+// Input corpora for the parser, one token per record.
+enum Corpus { CORPUS_INTEGERS, CORPUS_DECIMALS, CORPUS_MIXED, NUM_CORPORA };
+static const char *corpus_names[NUM_CORPORA] = {"integers", "decimals", "mixed"};
+
+// Tokens strtod() and the fast path might disagree on.
+static const char *tricky_tokens[] = {
+    "-0",    "+.5",   "5.",    ".",     "-",       "e5",    "1e",  "1e+",
+    "1e-x",  "1.2.3", "0x1f",  "inf",   "-nan",    "1e400", "1e-400",
+    "4e-22", "9007199254740993",  "9007199254740992e3",  "0.1e-22",
+    "00000000000000000000000012.5000", "12345678901234567890", "1e23",
+    "1,5",   "\v7",   "\f-3",  "abc",   "2.2250738585072014e-308"};
+
+static int corpus_token(enum Corpus c, char *s, size_t size) {
+    switch (c == CORPUS_MIXED ? rand() % 6 : (int)c) {
+        case CORPUS_INTEGERS:
+            return snprintf(s, size, "%d", rand() % 100000);
+        case CORPUS_DECIMALS:
+            return snprintf(s, size, "%.1f", (double)rand() / RAND_MAX * 200 - 100);
+        case 2:
+            return snprintf(s, size, "%.17g", (double)rand() / RAND_MAX * 1e6);
+        case 3:
+            return snprintf(s, size, "%de%d", rand() % 1000 - 500, rand() % 61 - 30);
+        case 4:
+            return snprintf(s, size, "%.*f", rand() % 8, (double)rand() / RAND_MAX);
+        default:
+            return snprintf(s, size, "%s",
+                            tricky_tokens[rand() % (sizeof(tricky_tokens) /
+                                                    sizeof(tricky_tokens[0]))]);
+    }
+}
+
+// The tokenizer ttyplot used before its delimiter scanner: strtok() and strtod().
+static long long reference_parse(char *buffer, double *values) {
+    long long n = 0;
+    char *str = buffer, *token;
+    while ((token = strtok(str, " \t\r\n")) != NULL) {
+        str = NULL;
+        char *number_end;
+        double value = strtod(token, &number_end);
+        if (*number_end == '\0' && isfinite(value))
+            values[n++] = value;
+    }
+    return n;
+}
+
+static long long scanner_parse(char *buffer, size_t length, double *values) {
+    long long n = 0;
+    struct token_scanner scanner;
+    char *token;
+    size_t token_length;
+    token_scanner_init(&scanner, buffer, length);
+    while (token_scanner_next(&scanner, &token, &token_length))
+        if (parse_number(token, token_length, &values[n]))
+            n++;
+    return n;
+}
+
+static void bench_parse(enum Corpus c, long long tokens) {
+    static const char delimiters[] = " \t\r\n";
+    const size_t size = tokens * 48 + 1;
+    char *corpus = malloc(size), *buffer = malloc(size);
+    double *expected = malloc(tokens * sizeof(double));
+    double *actual = malloc(tokens * sizeof(double));
+    long long mismatches = 0;
+    size_t length = 0;
+
+    srand(1);
+    for (long long i = 0; i < tokens; i++) {
+        length += corpus_token(c, corpus + length, 40);
+        do  // runs of mixed delimiters, mostly single newlines
+            corpus[length++] = (rand() % 8) ? '\n' : delimiters[rand() % 4];
+        while (rand() % 16 == 0);
+    }
+    corpus[length] = '\0';
+    memset(expected, 0, tokens * sizeof(double));  // keep page faults out of timings
+    memset(actual, 0, tokens * sizeof(double));
+
+    memcpy(buffer, corpus, length + 1);
+    double start = monotonic_now();
+    const long long n_expected = reference_parse(buffer, expected);
+    const double reference_time = monotonic_now() - start;
+
+    memcpy(buffer, corpus, length + 1);
+    start = monotonic_now();
+    const long long n_actual = scanner_parse(buffer, length, actual);
+    const double scanner_time = monotonic_now() - start;
+
+    // Differential check against strtod(), bit for bit.
+    if (n_actual != n_expected)
+        mismatches++;
+    for (long long i = 0; i < n_actual && i < n_expected; i++)
+        if (memcmp(&actual[i], &expected[i], sizeof(double)) != 0)
+            mismatches++;
+    if (memcmp(buffer, corpus, length + 1) != 0)  // the input must be left intact
+        mismatches++;
+    for (size_t i = 0; i + 64 <= length; i += 64)
+        if (delimiter_mask(corpus + i) != delimiter_mask_scalar(corpus + i))
+            mismatches++;
+
+    printf("parse corpus=%s tokens=%lld valid=%lld MB_per_s=%.1f "
+           "strtod_ns_per_token=%.1f scanner_ns_per_token=%.1f mismatches=%lld\n",
+           corpus_names[c], tokens, n_expected, length / scanner_time / 1e6,
+           reference_time * 1e9 / tokens, scanner_time * 1e9 / tokens, mismatches);
+    free(corpus);
+    free(buffer);
+    free(expected);
+    free(actual);
+}
+
+// Streams for the percentiles: the workloads, and latencies, log-normally distributed.
+static const char *quantile_streams[] = {"sine", "metrics", "random", "latency"};
+#define QUANTILE_WINDOW 1000  // values in the sliding window, as of a wide terminal
+
+static double quantile_stream_value(int stream, long long i) {
+    if (stream < NUM_WORKLOADS)
+        return workload_value(stream, i);
+    const double u1 = (rand() + 1.0) / (RAND_MAX + 2.0), u2 = (double)rand() / RAND_MAX;
+    return exp(2 + 0.6 * sqrt(-2 * log(u1)) * cos(2 * M_PI * u2));  // Box-Muller
+}
+
+static int compare_doubles(const void *a, const void *b) {
+    const double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Check the p50, p95 and p99 of q against those of the n values in sorted: the
+// estimate must be in the bucket of the exact value, so within 1/128 of it. Return
+// the number of misses, and keep track of the largest relative error.
+static long long check_quantiles(const struct quantiles *q, const double *sorted,
+                                 long long n, double *max_error) {
+    static const double ps[] = {0.50, 0.95, 0.99};
+    long long misses = 0;
+    for (int j = 0; j < 3; j++) {
+        const double exact = sorted[(long long)ceil(ps[j] * n) - 1];
+        const double estimate = quantiles_get(q, ps[j], sorted[0], sorted[n - 1]);
+        const double error = fabs(estimate - exact);
+        if (error > fabs(exact) / (2 * QUANTILE_SUBS) + ldexp(1, QUANTILE_MIN_EXP))
+            misses++;
+        if (exact != 0 && error / fabs(exact) > *max_error)
+            *max_error = error / fabs(exact);
+    }
+    return misses;
+}
+
+// Streaming percentiles (-P) against an exact sort, of the whole stream (session)
+// and of a sliding window of QUANTILE_WINDOW values, checked every QUANTILE_WINDOW.
+static void bench_quantiles(int stream, long long records) {
+    double *x = malloc(records * sizeof(double));
+    double *sorted = malloc(records * sizeof(double));
+    struct quantiles session = {0}, window = {0};
+    long long errors = 0, checks = 0;
+    double max_error = 0;
+
+    srand(1);
+    for (long long i = 0; i < records; i++)
+        x[i] = quantile_stream_value(stream, i);
+    quantiles_reset(&session);
+    quantiles_reset(&window);
+
+    double start = monotonic_now();
+    for (long long i = 0; i < records; i++)
+        quantiles_add(&session, x[i], 1);
+    const double add_time = monotonic_now() - start;
+
+    start = monotonic_now();
+    for (long long i = 0; i < records; i++) {
+        quantiles_add(&window, x[i], 1);
+        if (i >= QUANTILE_WINDOW)
+            quantiles_add(&window, x[i - QUANTILE_WINDOW], -1);
+    }
+    const double slide_time = monotonic_now() - start;
+
+    // The same slide, stopping to check.
+    quantiles_reset(&window);
+    for (long long i = 0; i < records; i++) {
+        quantiles_add(&window, x[i], 1);
+        if (i >= QUANTILE_WINDOW)
+            quantiles_add(&window, x[i - QUANTILE_WINDOW], -1);
+        if ((i + 1) % QUANTILE_WINDOW == 0) {
+            const long long n = (i + 1 < QUANTILE_WINDOW) ? i + 1 : QUANTILE_WINDOW;
+            memcpy(sorted, x + i + 1 - n, n * sizeof(double));
+            qsort(sorted, n, sizeof(double), compare_doubles);
+            errors += check_quantiles(&window, sorted, n, &max_error);
+            checks++;
+        }
+    }
+
+    memcpy(sorted, x, records * sizeof(double));
+    start = monotonic_now();
+    qsort(sorted, records, sizeof(double), compare_doubles);
+    const double sort_time = monotonic_now() - start;
+    errors += check_quantiles(&session, sorted, records, &max_error);
+    checks++;
+
+    printf("quantiles stream=%s records=%lld add_ns_per_value=%.2f "
+           "slide_ns_per_value=%.2f sort_ns_per_value=%.2f checks=%lld "
+           "max_rel_error=%.5f errors=%lld\n",
+           quantile_streams[stream], records, add_time * 1e9 / records,
+           slide_time * 1e9 / records, sort_time * 1e9 / records, checks, max_error,
+           errors);
+    free(x);
+    free(sorted);
+    free(session.buckets);
+    free(window.buckets);
+}
+
+// Row maps of the renderers: the ASCII plot and braille dots, 40 rows high.
+static const struct {
+    const char *name;
+    struct row_map map;
+} row_maps[] = {
+    {"ascii", {-100, 200, -INFINITY, INFINITY, 40}},
+    {"dots", {-50, 100, 0, 1, 159}},
+};
+
+static void bench_rows(int m, long long values) {
+    const struct row_map *map = &row_maps[m].map;
+    double *x = malloc(values * sizeof(double));
+    int *expected = malloc(values * sizeof(int));
+    int *actual = malloc(values * sizeof(int));
+    long long mismatches = 0;
+
+    // Mostly values in range, with ties, and now and then NaN or values far out of it,
+    // which the vector kernels leave to the scalar code.
+    srand(1);
+    for (long long i = 0; i < values; i++) {
+        const int r = rand() % 256;
+        if (r == 0)
+            x[i] = NAN;
+        else if (r == 1)
+            x[i] = (rand() % 2 ? 1 : -1) * 1e18 * rand();
+        else if (r < 32)  // halfway between two rows
+            x[i] = map->min + (rand() % 40 + 0.5) * map->range / map->scale;
+        else
+            x[i] = workload_value(WORKLOAD_RANDOM, i);
+    }
+    memset(expected, 0, values * sizeof(int));  // keep page faults out of timings
+    memset(actual, 0, values * sizeof(int));
+
+    double start = monotonic_now();
+    value_rows_scalar(x, values, map, expected);
+    const double scalar_time = monotonic_now() - start;
+
+    start = monotonic_now();
+    value_rows(x, values, map, actual);
+    const double vector_time = monotonic_now() - start;
+
+    for (long long i = 0; i < values; i++)
+        if (actual[i] != expected[i])
+            mismatches++;
+
+    printf("rows map=%s values=%lld scalar_ns_per_value=%.2f "
+           "vector_ns_per_value=%.2f mismatches=%lld\n",
+           row_maps[m].name, values, scalar_time * 1e9 / values,
+           vector_time * 1e9 / values, mismatches);
+    free(x);
+    free(expected);
+    free(actual);
+}
+
+// Rendering modes, as set by ttyplot's command line options.
+static const struct {
+    const char *name;
+    int series, rate, braille, block, aa;
+    int fold_size;  // records per column, folded into an envelope (-a envelope)
+    enum HeatScale heatmap;
+} render_modes[] = {
+    {"ascii", 1, 0, 0, 0, 0, 1, HEAT_NONE},             // no options
+    {"two", 2, 0, 0, 0, 0, 1, HEAT_NONE},               // -2
+    {"rate", 1, 1, 0, 0, 0, 1, HEAT_NONE},              // -r
+    {"braille", 1, 0, 1, 0, 0, 1, HEAT_NONE},           // -b
+    {"braille_two", 2, 0, 1, 0, 0, 1, HEAT_NONE},       // -b -2
+    {"block", 1, 0, 0, 1, 0, 1, HEAT_NONE},             // -B
+    {"envelope", 2, 0, 0, 0, 0, 4, HEAT_NONE},          // -2 -K 4 -a envelope
+    {"braille_envelope", 1, 0, 1, 0, 0, 4, HEAT_NONE},  // -b -K 4 -a envelope
+    {"heatmap", 1, 0, 0, 1, 0, 8, HEAT_LOG},            // -B -K 8 -d log
+#ifdef AALIB
+    {"aa", 1, 0, 0, 0, 1, 1, HEAT_NONE},  // -A
+#endif
+};
+
+#define RENDER_ROWS 50
+#define RENDER_COLUMNS 200
+#define RENDER_RECORDS_PER_FRAME 8
+#define RENDER_FRAME_INTERVAL_US 33333  // input timestamps advance as at 30 fps
+
+static size_t terminal_bytes;  // written by count_terminal_bytes()
+
+// The terminal: a pipe whose other end is drained and counted by this thread.
+static void *count_terminal_bytes(void *arg) {
+    const int fd = *(int *)arg;
+    static char buffer[65536];
+    ssize_t n;
+    terminal_bytes = 0;
+    while ((n = read(fd, buffer, sizeof(buffer))) > 0 || (n < 0 && errno == EINTR))
+        if (n > 0)
+            terminal_bytes += n;
+    return NULL;
+}
+
+#define RATE_READS 200
+#define RATE_INTERVAL 0.1  // seconds between reads
+
+// Rates (-r) of a counter read one record per read, at a steady pace, as from a
+// producer printing once per interval: every rate after the first record must be the
+// same, whatever the number of digits.
+static void check_rates(void) {
+    series = 1;
+    rate = 1;
+    history_reset();
+    memset(counters, 0, sizeof(counters));
+    resize_values(RATE_READS);
+    window_stats_rebuild(&stats[0], 0, RATE_READS);
+    ingest_clock = 0;
+    for (int i = 0; i < RATE_READS; i++) {
+        char line[32];
+        const int length = sprintf(line, "%d\n", i * 5);
+        previous_ingest_clock = ingest_clock;
+        ingest_clock += RATE_INTERVAL;
+        handle_input_data(line, length);
+        ingest_drain();
+    }
+
+    long long errors = (v != RATE_READS || ! isnan(get_value(0, 0))) ? 1 : 0;
+    for (long long i = 1; i < v; i++)
+        errors += fabs(get_value(0, i) - 5 / RATE_INTERVAL) > 1e-6;
+    printf("rates reads=%d expected=%.1f errors=%lld\n", RATE_READS, 5 / RATE_INTERVAL,
+           errors);
+    rate = 0;
+}
+
+// Replay a workload through ttyplot's own path, from a chunk of text input to the
+// screen: handle_input_data(), ingest_drain(), then redraw_screen() once per frame,
+// on an ncurses screen of RENDER_ROWS x RENDER_COLUMNS writing into a pipe.
+static void bench_render(int mode, long long frames) {
+    const long long records = frames * RENDER_RECORDS_PER_FRAME;
+    series = render_modes[mode].series;
+    rate = render_modes[mode].rate;
+    braille = render_modes[mode].braille;
+    block = render_modes[mode].block;
+    aa = render_modes[mode].aa;
+    fold_size = render_modes[mode].fold_size;
+    aggregation = (fold_size > 1) ? AGGREGATE_ENVELOPE : AGGREGATE_AVG;
+    heatmap = render_modes[mode].heatmap;
+    heat_step = 0;  // bins from the first sample on
+    memset(heat_open, 0, sizeof(heat_open));
+    fake_clock = true;  // the same bytes on every run
+
+    // The input text, with the offset at which each frame's records end.
+    char *text = malloc(records * series * 8 + 1);
+    size_t *frame_end = malloc(frames * sizeof(size_t));
+    size_t length = 0;
+    for (long long i = 0; i < records; i++) {
+        for (int k = 0; k < series; k++)
+            length += sprintf(text + length, "%.1f%c",
+                              workload_value(WORKLOAD_METRICS, i + 37 * k),
+                              (k + 1 < series) ? ' ' : '\n');
+        if ((i + 1) % RENDER_RECORDS_PER_FRAME == 0)
+            frame_end[i / RENDER_RECORDS_PER_FRAME] = length;
+    }
+
+    int terminal[2];
+    pthread_t counter;
+    FILE *out = NULL, *in = fopen("/dev/null", "r");
+    if (pipe(terminal) == 0)
+        out = fdopen(terminal[1], "w");
+    if (out == NULL || in == NULL ||
+        pthread_create(&counter, NULL, count_terminal_bytes, &terminal[0]) != 0) {
+        fprintf(stderr, "Error: cannot set up the terminal pipe\n");
+        exit(1);
+    }
+    SCREEN *screen = newterm("xterm", out, in);
+    if (screen == NULL) {
+        fprintf(stderr, "Error: no terminfo entry for xterm\n");
+        exit(1);
+    }
+    resize_term(RENDER_ROWS, RENDER_COLUMNS);
+    start_color();
+    use_default_colors();
+    init_pair(PAIR_BR1, C_GREEN, -1);
+    init_pair(PAIR_BR2, C_BLUE, -1);
+    curs_set(FALSE);
+    getmaxyx(stdscr, height, width);
+
+    // A fresh session.
+    history_reset();
+    memset(counters, 0, sizeof(counters));
+    ingest_time = (struct timeval){.tv_sec = 1700000000};
+    ingest_clock = 0;
+    previous_ingest_clock = -RENDER_FRAME_INTERVAL_US * 1e-6;
+    plotwidth = width - WIDTH_MARGIN;
+    resize_values((history > plotwidth) ? history : plotwidth);
+    for (int k = 0; k < series; k++)
+        window_stats_rebuild(&stats[k], k, plotwidth);
+
+    double render_time = 0;
+    const long long counted_bytes = output_bytes;
+    const double start = monotonic_now();
+    size_t offset = 0;
+    for (long long f = 0; f < frames; f++) {
+        offset += handle_input_data(text + offset, frame_end[f] - offset);
+        ingest_drain();
+        const double frame_start = monotonic_now();
+        redraw_screen(NULL);
+        render_time += monotonic_now() - frame_start;
+        ingest_time.tv_usec += RENDER_FRAME_INTERVAL_US;
+        if (ingest_time.tv_usec >= 1000000) {
+            ingest_time.tv_sec++;
+            ingest_time.tv_usec -= 1000000;
+        }
+        previous_ingest_clock = ingest_clock;
+        ingest_clock += RENDER_FRAME_INTERVAL_US * 1e-6;
+    }
+    const double total_time = monotonic_now() - start;
+
+    endwin();
+    delscreen(screen);
+    plot_pad = dots_pad = NULL;  // freed with the screen
+    pad_ph = dots_ph = -1;
+#ifdef AALIB
+    aa_pad = NULL;
+    aa_ph = -1;
+#endif
+    fclose(out);
+    pthread_join(counter, NULL);
+    close(terminal[0]);
+    fclose(in);
+
+    printf("render mode=%s frames=%lld records=%lld samples_per_s=%.0f "
+           "frames_per_s=%.1f ns_per_frame=%.0f bytes_per_frame=%.1f "
+           "counted_bytes_per_frame=%.1f errors=%lld\n",
+           render_modes[mode].name, frames, records, records * series / total_time,
+           frames / total_time, render_time * 1e9 / frames,
+           (double)terminal_bytes / frames, (double)(output_bytes - counted_bytes) / frames,
+           (v != records / fold_size) ? 1LL : 0LL);
+    free(text);
+    free(frame_end);
+    fold_size = 1;
+    aggregation = AGGREGATE_AVG;
+    heatmap = HEAT_NONE;
+}
+
+// Variants of the ASCII plot, each taking its own branches in plot_columns().
+static const struct {
+    const char *name;
+    int series;
+    double offset;   // added to the values, negative ones need the signed range
+    bool colors;     // -C
+    double hardmax;  // -m, values above it are drawn as errors
+} column_variants[] = {
+    {"one", 1, 0, false, FLT_MAX},    {"two", 2, 0, false, FLT_MAX},
+    {"signed", 2, -30, false, FLT_MAX}, {"colors", 2, 0, true, FLT_MAX},
+    {"limits", 2, 0, false, 40},
+};
+
+// The ASCII column drawing alone: full redraws of plot_pad with plot_values(), from
+// records already in the ring buffer, without updating the screen.
+static void bench_columns(int variant, long long frames) {
+    const int ph = RENDER_ROWS - HEIGHT_MARGIN, pw = RENDER_COLUMNS - WIDTH_MARGIN;
+    FILE *out = fopen("/dev/null", "w"), *in = fopen("/dev/null", "r");
+    SCREEN *screen = (out && in) ? newterm("xterm", out, in) : NULL;
+    if (screen == NULL) {
+        fprintf(stderr, "Error: no terminfo entry for xterm\n");
+        exit(1);
+    }
+    resize_term(RENDER_ROWS, RENDER_COLUMNS);
+    start_color();
+    if (column_variants[variant].colors) {
+        colors[LINE_COLOR] = C_BLUE;
+        colors[MAX_ERROR_COLOR] = C_RED;
+        init_pair(LINE_COLOR + 1, C_BLUE, -1);
+        init_pair(MAX_ERROR_COLOR + 1, C_RED, -1);
+    }
+    plotchar.chars[0] = '|';
+    max_errchar.chars[0] = 'e';
+    min_errchar.chars[0] = 'v';
+
+    series = column_variants[variant].series;
+    rate = braille = block = aa = 0;
+    resize_values(pw);
+    char *text = malloc((size_t)pw * series * 8 + 1);
+    size_t length = 0;
+    double max = -FLT_MAX, min = FLT_MAX;
+    for (long long i = 0; i < pw; i++)
+        for (int k = 0; k < series; k++) {
+            const double value = workload_value(WORKLOAD_METRICS, i + 37 * k) +
+                                 column_variants[variant].offset;
+            length += sprintf(text + length, "%.1f%c", value,
+                              (k + 1 < series) ? ' ' : '\n');
+            max = (value > max) ? value : max;
+            min = (value < min) ? value : min;
+        }
+    handle_input_data(text, length);
+    ingest_drain();
+    if (column_variants[variant].hardmax != FLT_MAX)
+        max = column_variants[variant].hardmax;
+    if (min > 0)
+        min = 0;
+
+    const double start = monotonic_now();
+    for (long long f = 0; f < frames; f++) {
+        pad_max = NAN;  // force a full redraw
+        plot_values(ph, pw, max, min, &plotchar, &max_errchar, &min_errchar,
+                    column_variants[variant].hardmax, -FLT_MAX);
+    }
+    const double total_time = monotonic_now() - start;
+
+    printf("columns variant=%s frames=%lld columns=%d ns_per_column=%.1f\n",
+           column_variants[variant].name, frames, pw, total_time * 1e9 / frames / pw);
+
+    endwin();
+    delscreen(screen);
+    plot_pad = NULL;  // freed with the screen
+    pad_ph = -1;
+    colors[LINE_COLOR] = colors[MAX_ERROR_COLOR] = -1;
+    fclose(out);
+    fclose(in);
+    free(text);
+}
+
+int main(int argc, char *argv[]) {
+    long long records = 1000000, frames = 2000;
+    int opt;
+
+    while ((opt = getopt(argc, argv, bench_optstring)) != -1) {
+        switch (opt) {
+            case 'h':
+                printf(bench_help);
+                return EXIT_SUCCESS;
+            case 'n':
+                records = atoll(optarg);
+                break;
+            case 'f':
+                frames = atoll(optarg);
+                break;
+            default:
+                fprintf(stderr, bench_help);
+                return EXIT_FAILURE;
+        }
+    }
+    if (argc > optind || records < 1 || frames < 1) {
+        fprintf(stderr, bench_help);
+        return EXIT_FAILURE;
+    }
+
+    for (int w = 0; w < NUM_WORKLOADS; w++)
+        bench_history(w, records);
+    for (int c = 0; c < NUM_CORPORA; c++)
+        bench_parse(c, records);
+    for (int m = 0; m < (int)(sizeof(row_maps) / sizeof(row_maps[0])); m++)
+        bench_rows(m, records);
+    for (int q = 0; q < (int)(sizeof(quantile_streams) / sizeof(quantile_streams[0]));
+         q++)
+        bench_quantiles(q, records);
+
+    series = MAX_SERIES;  // room for any mode
+    ingest_setup();
+    setup_output_counter();  // what ttyplot itself counts, vs. what the pipe gets
+    check_rates();
+    for (int m = 0; m < (int)(sizeof(render_modes) / sizeof(render_modes[0])); m++)
+        bench_render(m, frames);
+    for (int c = 0; c < (int)(sizeof(column_variants) / sizeof(column_variants[0])); c++)
+        bench_columns(c, frames);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,48 @@
+#! /usr/bin/env bash
+##
+## Apache License 2.0
+##
+## Feeds ttyplot with stresstest while its terminal output drains at a trickle,
+## and fails if stresstest got blocked writing: reading the input must go on
+## while the screen waits for the terminal.
+##
+
+set -e -u
+
+self_dir="$(dirname "$(realpath "$(type -P "$0")")")"
+cd "${self_dir}/.."  # i.e. the local build
+
+duration=${STALL_TEST_DURATION:-15}  # seconds
+stalls="$(mktemp)"
+trap 'rm -f "${stalls}"' EXIT
+
+# A terminal taking 640 bytes per second, far less than ttyplot paints at 10 fps, for
+# the duration of the test, and then all the rest, so that ttyplot can exit.
+drain() {
+    local end=$((SECONDS + duration))
+    while ((SECONDS < end)) && sleep 0.1; do
+        dd bs=64 count=1 2> /dev/null
+    done
+    cat
+}
+
+# timeout exits with 124 if ttyplot was still running when it sent SIGINT: a crash or
+# an early exit would also leave no stalls, as stresstest then dies of SIGPIPE.
+# MallocNanoZone=0 is for AddressSanitizer on macOS, see https://stackoverflow.com/a/70209891/11626624 .
+set +e
+./stresstest -2 -R -r 100000 -l 100 2> "${stalls}" \
+    | TERM=xterm MallocNanoZone=0 timeout -s INT "${duration}" ./ttyplot -2 -b -F 10 \
+    | drain > /dev/null
+statuses=("${PIPESTATUS[@]}")
+set -e
+
+if [[ "${statuses[1]}" -ne 124 ]]; then
+    echo "FAIL: ttyplot exited with status ${statuses[1]} before the end of the test" >&2
+    exit 1
+fi
+if [[ -s "${stalls}" ]]; then
+    cat "${stalls}" >&2
+    echo "FAIL: ttyplot stopped reading its input" >&2
+    exit 1
+fi
+echo "PASS: no write blocked for more than 100 ms in ${duration} seconds"
@@ -13,6 +13,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <time.h>
 #include <unistd.h>
 #include <string.h>
@@ -20,20 +21,78 @@
 
 const char help[] =
     "Usage:\n"
-    "  stresstest [-2] [-c] [-g] [-m] [-n] [-R] [-r rate]\n"
+    "  stresstest [-2] [-c] [-g] [-m] [-n] [-R] [-r rate] [-I format] [-l ms]\n"
     "  stresstest -h\n"
     "\n"
     "  -h       print this help message and exit\n"
     "  -2       output two waves\n"
     "  -c       randomly chunk the output\n"
-    "  -g       occasionally output garbage\n"
+    "  -g       occasionally output garbage (text only)\n"
     "  -m       output realistic metrics (CPU/bandwidth-like, random spikes)\n"
     "  -n       output negative values\n"
     "  -R       output uniformly random values across the full range\n"
     "  -r rate  sample rate in samples/s (default: 100)\n"
-    "  -s seed  set random seed\n";
+    "  -s seed  set random seed\n"
+    "  -I format  output format, as for ttyplot -I: text, f64le, f32le, i32le or\n"
+    "           i64le (default: text)\n"
+    "  -l ms    report on stderr each write blocked for longer than ms milliseconds,\n"
+    "           a sign that the reader is not keeping up\n";
 
-const char optstring[] = "h2cgmnRr:s:";
+const char optstring[] = "h2cgmnRr:s:I:l:";
+
+enum Format { FORMAT_TEXT, FORMAT_F64LE, FORMAT_F32LE, FORMAT_I32LE, FORMAT_I64LE };
+static const char *format_names[] = {"text", "f64le", "f32le", "i32le", "i64le"};
+
+// Write one sample in the given format. Return the number of bytes written.
+static size_t put_sample(char *out, enum Format format, double value) {
+    uint64_t bits = 0;
+    int bytes = 0;
+    switch (format) {
+        case FORMAT_TEXT:
+            return sprintf(out, "%.1f\n", value);
+        case FORMAT_F64LE:
+            memcpy(&bits, &value, sizeof(value));
+            bytes = 8;
+            break;
+        case FORMAT_F32LE: {
+            const float f = value;
+            uint32_t bits32;
+            memcpy(&bits32, &f, sizeof(f));
+            bits = bits32;
+            bytes = 4;
+            break;
+        }
+        case FORMAT_I32LE:
+            bits = (uint32_t)(int32_t)lround(value);
+            bytes = 4;
+            break;
+        case FORMAT_I64LE:
+            bits = (uint64_t)(int64_t)llround(value);
+            bytes = 8;
+            break;
+    }
+    for (int i = 0; i < bytes; i++)
+        out[i] = (char)(bits >> (8 * i));
+    return bytes;
+}
+
+static double stall_limit = 0;  // -l, in seconds, 0 = do not report
+
+static double monotonic_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+// Write to stdout, reporting a write that blocked for longer than stall_limit.
+static ssize_t timed_write(const char *data, size_t size) {
+    const double start = monotonic_now();
+    const ssize_t bytes_sent = write(STDOUT_FILENO, data, size);
+    const double blocked = monotonic_now() - start;
+    if (stall_limit > 0 && blocked > stall_limit)
+        fprintf(stderr, "stresstest: write blocked for %.0f ms\n", blocked * 1e3);
+    return bytes_sent;
+}
 
 // Return a uniformly random value in [lo, hi].
 static double rand_range(double lo, double hi) {
@@ -71,6 +130,7 @@ int main(int argc, char *argv[]) {
     bool output_negative = false;
     double rate = 100;
     unsigned int seed = time(NULL);
+    enum Format format = FORMAT_TEXT;
 
     // Parse the command line.
     while ((opt = getopt(argc, argv, optstring)) != -1) {
@@ -102,6 +162,19 @@ int main(int argc, char *argv[]) {
             case 's':
                 seed = atoi(optarg);
                 break;
+            case 'l':
+                stall_limit = atof(optarg) / 1e3;
+                break;
+            case 'I':
+                format = FORMAT_TEXT;
+                while (format < FORMAT_I64LE &&
+                       strcmp(optarg, format_names[format]) != 0)
+                    format++;
+                if (strcmp(optarg, format_names[format]) != 0) {
+                    fprintf(stderr, help);
+                    return EXIT_FAILURE;
+                }
+                break;
             default:
                 fprintf(stderr, help);
                 return EXIT_FAILURE;
@@ -112,6 +185,9 @@ int main(int argc, char *argv[]) {
         return EXIT_FAILURE;
     }
 
+    if (format != FORMAT_TEXT)
+        add_garbage = false;  // it would shift all the samples that follow
+
     const useconds_t delay = 1e6 / rate;
     srand(seed);
 
@@ -128,7 +204,7 @@ int main(int argc, char *argv[]) {
             wave1 = rand_range(rmin, rmax);
         else
             wave1 = (sin(n * M_PI / 180) * 5) + (output_negative ? 0 : 5);
-        buffer_pos += sprintf(buffer + buffer_pos, "%.1f\n", wave1);
+        buffer_pos += put_sample(buffer + buffer_pos, format, wave1);
         if (add_garbage && rand() <= RAND_MAX / 5)
             buffer_pos += sprintf(buffer + buffer_pos, "garbage ");
         if (two_waves) {
@@ -139,7 +215,7 @@ int main(int argc, char *argv[]) {
                 wave2 = rand_range(rmin, rmax);
             else
                 wave2 = (cos(n * M_PI / 180) * 5) + (output_negative ? 0 : 5);
-            buffer_pos += sprintf(buffer + buffer_pos, "%.1f\n", wave2);
+            buffer_pos += put_sample(buffer + buffer_pos, format, wave2);
             if (add_garbage && rand() <= RAND_MAX / 5)
                 buffer_pos += sprintf(buffer + buffer_pos, "garbage ");
         }
@@ -148,7 +224,7 @@ int main(int argc, char *argv[]) {
             while (buffer_pos - send_pos >= 16) {
                 const size_t bytes_to_send = 1 + rand() % 16;  // 1..16
                 const ssize_t bytes_sent =
-                    write(STDOUT_FILENO, buffer + send_pos, bytes_to_send);
+                    timed_write(buffer + send_pos, bytes_to_send);
                 usleep(50);  // let ttyplot read this before proceeding
                 if (bytes_sent > 0)
                     send_pos += bytes_sent;
@@ -157,7 +233,7 @@ int main(int argc, char *argv[]) {
                 memmove(buffer, buffer + send_pos, buffer_pos - send_pos);
             buffer_pos -= send_pos;
         } else {
-            const ssize_t bytes_sent = write(STDOUT_FILENO, buffer, buffer_pos);
+            const ssize_t bytes_sent = timed_write(buffer, buffer_pos);
             if ((bytes_sent > 0) && ((size_t)bytes_sent < buffer_pos))
                 memmove(buffer, buffer + bytes_sent, buffer_pos - bytes_sent);
             if (bytes_sent > 0)
@@ -21,12 +21,16 @@
 #include <assert.h>
 #include <ctype.h>  // isspace
 #include <math.h>
+#include <stdarg.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <float.h>
+#include <limits.h>  // MB_LEN_MAX, INT_MIN
+#include <wchar.h>
 #include <time.h>
 #include <sys/time.h>
 #include <locale.h>
@@ -36,11 +40,26 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
 
 #ifdef __OpenBSD__
 #include <err.h>
 #endif
 
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+#endif
+
+// Linux-specific, but hidden from the _XOPEN_SOURCE namespace.
+#if defined(__linux__) && ! defined(F_SETPIPE_SZ)
+#define F_SETPIPE_SZ 1031
+#endif
+
 // Experimental, opt-in ASCII-art rendering backend (build with -DAALIB -laa).
 #ifdef AALIB
 #include <aalib.h>
@@ -49,6 +68,12 @@
 #define AA_OPT ""
 #endif
 
+// SIMD input scanning: SSE2 is part of x86-64, AVX2 is detected at runtime.
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#define X86_SIMD
+#endif
+
 #define T_RARR '>'
 #define T_UARR '^'
 #ifdef NOACS
@@ -79,9 +104,11 @@
 #define C_CYAN 6
 #define C_WHITE 7
 
-#define PAIR_BR1 8
+#define PAIR_BR1 8  // series k is drawn in pair PAIR_BR1 + k (braille/block/aa)
 #define PAIR_BR2 9
 
+#define MAX_SERIES 16  // values per record (-N)
+
 // Define color element indices
 enum ColorElement {
     LINE_COLOR = 0,
@@ -108,8 +135,16 @@ static struct timeval now;
 static double td;
 static double softmax = 0.0, hardmax = FLT_MAX, softmin = 0.0, hardmin = -FLT_MAX;
 static char title[256] = ".: ttyplot :.", unit[64] = {0}, ls[256] = {0};
-static double values1[1024] = {0}, values2[1024] = {0};
-static int width = 0, height = 0, n = -1, v = 0, c = 0, rate = 0, two = 0,
+// Ring buffer of records: record number i is stored at slot i % capacity, which holds
+// its `series` values side by side, so that a column of the plot is one cache line.
+// It holds the newest max(history, plotwidth) records, so widening the terminal
+// brings older records back into view.
+static double *values = NULL;
+static int capacity = 0, history = 1024;
+static long long v = 0;  // number of records stored, see store_column()
+static long long input_records = 0;  // number of records received
+static int series = 1;   // values per record: -2, -N
+static int width = 0, height = 0, c = 0, rate = 0,
            plotwidth = WIDTH_MIN - WIDTH_MARGIN, plotheight = 0;
 static bool fake_clock = false;
 static int braille = 0;
@@ -118,6 +153,39 @@ static int block = 0;
 static int aa = 0;  // only settable when compiled with -DAALIB (see optstring)
 static char *errstr = NULL;
 static bool redraw_needed = false;
+// Input format (-I): text, or fixed-size little-endian binary samples.
+enum InputFormat { INPUT_TEXT, INPUT_F64LE, INPUT_F32LE, INPUT_I32LE, INPUT_I64LE };
+static const struct {
+    const char *name;
+    size_t size;  // bytes per sample
+} input_formats[] = {
+    {"text", 0}, {"f64le", 8}, {"f32le", 4}, {"i32le", 4}, {"i64le", 8}};
+static enum InputFormat input_format = INPUT_TEXT;
+static const char *follow_path = NULL;  // -i: file followed instead of stdin
+static int fps = 30;                     // maximum repaints per second, 0 = no cap
+static double bucket_interval = 0;       // -T: seconds per column, 0 = one per record
+static int fold_size = 1;                // -K: records per column, without -T
+// What a column of folded records shows (-a).
+enum Aggregation {
+    AGGREGATE_AVG,
+    AGGREGATE_MIN,
+    AGGREGATE_MAX,
+    AGGREGATE_LAST,
+    AGGREGATE_ENVELOPE
+};
+static const char *aggregation_names[] = {"avg", "min", "max", "last", "envelope"};
+static enum Aggregation aggregation = AGGREGATE_AVG;
+// Percentiles shown in the status line (-P), of the records in view or of all input.
+enum Percentiles { PERCENTILES_NONE, PERCENTILES_WINDOW, PERCENTILES_SESSION };
+static const char *percentiles_names[] = {"none", "window", "session"};
+static enum Percentiles percentiles = PERCENTILES_NONE;
+// Heatmap mode (-d): how the rows of the heatmap divide values.
+enum HeatScale { HEAT_NONE, HEAT_LINEAR, HEAT_LOG };
+static const char *heat_scale_names[] = {"none", "linear", "log"};
+static enum HeatScale heatmap = HEAT_NONE;
+static bool show_frame_records = false;  // -F given: show records/frame in status
+static int pending_records = 0;          // records received since the last repaint
+static int frame_records = 0;            // records folded into the frame on screen
 // Array of colors for different elements, -1 means no color specified
 static int colors[NUM_COLOR_ELEMENTS] = {-1, -1, -1, -1, -1, -1};
 static int line2color = -1;
@@ -126,12 +194,17 @@ static const char *verstring = "https://github.com/tenox7/ttyplot " VERSION_STR;
 static void usage(void) {
     printf(
         "Usage:\n"
-        "  ttyplot [-2] [-r] [-c plotchar] [-s scale] [-m max] [-M min] [-t title] [-u "
-        "unit]\n"
+        "  ttyplot [-2] [-N series] [-r] [-R] [-c plotchar] [-s scale] [-m max] "
+        "[-M min] [-t title] [-u unit] [-D] [-F fps] [-H history] [-I format] "
+        "[-i file [-O offset]] [-o file [-w seconds]] [-T seconds | -K records] "
+        "[-a mode] [-P scope] [-d scale] [-Z KiB]\n"
         "  ttyplot -h\n"
         "  ttyplot -v\n"
         "\n"
         "  -2 read two values and draw two plots, the second one is in reverse video\n"
+        "  -N read this many values per record and draw one plot each (max 16), "
+        "beyond two\n"
+        "     the plots are marked 3, 4, ... in the default mode\n"
         "  -b braille line drawing mode (two lines distinguished by color)\n"
         "  -B block elements drawing mode (quadrants), like -b\n"
         "  -f fill area under the line in braille/block mode (line 1)\n"
@@ -139,7 +212,11 @@ static void usage(void) {
         "  -A (experimental) aalib ASCII-art line mode, two lines in color (-f fills "
         "line 1)\n"
 #endif
-        "  -r rate of a counter (divide value by measured sample interval)\n"
+        "  -r rate of a counter: increase per second between records, a 32 or 64-bit "
+        "wrap counts on,\n"
+        "     a reset leaves a gap\n"
+        "  -R each record starts with its timestamp in seconds, eg from date +%%s.%%N, "
+        "for -r and -T\n"
         "  -c character to use for plot line, eg @ # %% . etc\n"
         "  -e character to use for error line when value exceeds hardmax (default: e)\n"
         "  -E character to use for error symbol displayed when value is less than "
@@ -152,6 +229,39 @@ static void usage(void) {
         "lower-limit of the plot scale is fixed\n"
         "  -t title of the plot\n"
         "  -u unit displayed beside vertical bar\n"
+        "  -D show the diagnostics overlay: input and screen refresh rates, rejected "
+        "input, bytes sent to the terminal\n"
+        "  -F maximum screen refreshes per second, 0 for no limit (default: 30)\n"
+        "  -H number of records kept, including those out of view (default: 1024)\n"
+        "  -I input format: text, or binary little-endian samples f64le, f32le, i32le "
+        "or i64le (default: text)\n"
+        "  -i follow a growing file instead of reading stdin, like tail -F\n"
+        "  -O byte offset in the -i file to start reading from, negative counts from "
+        "the end (default: end of file)\n"
+        "  -o headless: write text snapshots of the plot to a file, or - for stdout, "
+        "at exit\n"
+        "     (end of input or ^C) instead of using the terminal, sized by "
+        "$COLUMNS and $LINES\n"
+        "  -w with -o, also write a snapshot every this many seconds\n"
+        "  -T time-based X axis: each column covers this many seconds and shows the "
+        "records received in them (see -a), or a gap\n"
+        "  -K fold this many records into each column (see -a)\n"
+        "  -a how -T and -K fold records into a column: avg, min, max, last, or "
+        "envelope\n"
+        "     to draw a bar from min to max (default: avg)\n"
+        "  -P show the 50th, 95th and 99th percentiles of the records in view "
+        "(window) or of\n"
+        "     all input (session), within 1%% for magnitudes from 1e-19 to 1e19 "
+        "(default: none);\n"
+        "     with -K or -T, those of the window rank the values of its columns, as "
+        "per -a\n"
+        "  -d heatmap of the first series, with -K or -T: each cell shades how many "
+        "records\n"
+        "     of its column fell into its rows, on a linear or log scale; without "
+        "them, a column\n"
+        "     has one record\n"
+        "  -Z memory for the compressed session history in KiB, 0 to disable "
+        "(default: 16384)\n"
         "  -C color[/line2][,axes,text,title,max_err,min_err]  set colors (0-7):\n"
         "     First value: plot line color\n"
         "     Second value: axes color (optional)\n"
@@ -171,6 +281,7 @@ static void usage(void) {
         "Hotkeys:\n"
         "   q quit\n"
         "   r toggle rate mode\n"
+        "   d toggle the diagnostics overlay\n"
         "  ^L full screen refresh\n");
 }
 
@@ -217,53 +328,868 @@ static void set_color_scheme(const char *scheme_name) {
     }
 }
 
-// Replace *v1 and *v2 (if non-NULL) by their time derivatives.
-//  - v1, v2: addresses of input data and storage for results
-//  - now: current time
-// Return time since previous call.
-static double derivative(double *v1, double *v2, const struct timeval *now) {
-    static double previous_v1, previous_v2, previous_t = DBL_MAX;
-    const double t = now->tv_sec + 1e-6 * now->tv_usec;
-    const double dt = t - previous_t;
-    previous_t = t;
-    if (v1) {
-        const double dv1 = *v1 - previous_v1;
-        previous_v1 = *v1;
-        if (dt <= 0)
-            *v1 = 0;
-        else
-            *v1 = dv1 / dt;
+// Rate of counters (-r): the previous value of each series, and when it came.
+static struct {
+    double value, t;
+    bool known;
+} counters[MAX_SERIES];
+
+// Increase of a counter from `previous` to `value`. Counters are unsigned integers:
+// a decrease of one is a wrap at 2^32, or 2^64 beyond that, if wrapping makes it an
+// increase by less than half of that range, and a reset otherwise: NAN, as it is
+// unknown how much the counter counted since. Other values can decrease.
+static double counter_increase(double previous, double value) {
+    if (value >= previous || value < 0 || value != floor(value) ||
+        previous != floor(previous))
+        return value - previous;
+    const double range = (previous < 0x1p32) ? 0x1p32 : 0x1p64;
+    const double wrapped = value + (range - previous);
+    return (wrapped < range / 2) ? wrapped : NAN;
+}
+
+// Replace the values of a record by their time derivatives.
+//  - record: the `series` input values, and storage for results
+//  - t: when the record came, in seconds (see handle_value())
+// A value without a previous one, or that came no later, gets NAN: the next one
+// covers the time since the previous one then. So does a missing (NAN) value.
+// Return the time since the previous record of the first series, or NAN.
+static double derivative(double *record, double t) {
+    double dt = NAN;
+    for (int k = 0; k < series; k++) {
+        if (isnan(record[k]))
+            continue;
+        if (! counters[k].known) {
+            counters[k].value = record[k];
+            counters[k].t = t;
+            counters[k].known = true;
+            record[k] = NAN;
+            continue;
+        }
+        if (t <= counters[k].t) {
+            record[k] = NAN;
+            continue;
+        }
+        const double elapsed = t - counters[k].t;
+        const double increase = counter_increase(counters[k].value, record[k]);
+        counters[k].value = record[k];
+        counters[k].t = t;
+        record[k] = increase / elapsed;
+        if (k == 0)
+            dt = elapsed;
+    }
+    return dt;
+}
+
+// Compressed history of the whole session, so that records which fell out of the
+// ring buffers can be brought back. Records are appended to fixed-size blocks the way
+// Gorilla (Facebook's in-memory time series database) does it: timestamps in
+// milliseconds as delta-of-delta, values as XOR with the previous value of the same
+// series. The oldest blocks are dropped to stay within the memory budget.
+#define HISTORY_BLOCK_BYTES 4096
+#define HISTORY_RECORD_BITS_MAX (4 + 64 + MAX_SERIES * (2 + 5 + 6 + 64))  // worst case
+
+struct history_block {
+    long long first;  // record number of the first record
+    int count;        // number of records
+    size_t bits;      // number of bits used in data
+    unsigned char data[HISTORY_BLOCK_BYTES];
+};
+
+// Delta coding state, the same for the encoder and the decoder.
+struct history_state {
+    long long t, dt;                                // previous timestamp and delta
+    uint64_t bits[MAX_SERIES];                      // previous values, as raw bits
+    int leading[MAX_SERIES], trailing[MAX_SERIES];  // previous XOR window, or -1
+};
+
+struct history_reader {
+    int block;        // index of the block within history_blocks
+    size_t pos;       // bit position within that block
+    int index;        // number of records of that block already decoded
+    long long record;  // record number of the next record
+    struct history_state state;
+};
+
+static struct history_block **history_blocks = NULL;  // ring of blocks, oldest first
+static int history_max_blocks = 0, history_first_block = 0, history_num_blocks = 0;
+static int history_budget = 16384;  // KiB, 0 disables the history
+static struct history_state history_encoder;
+
+static int count_leading_zeros(uint64_t x) {
+#ifdef __GNUC__
+    return __builtin_clzll(x);
+#else
+    int n = 0;
+    for (; ! (x & ((uint64_t)1 << 63)); x <<= 1)
+        n++;
+    return n;
+#endif
+}
+
+static int count_trailing_zeros(uint64_t x) {
+#ifdef __GNUC__
+    return __builtin_ctzll(x);
+#else
+    int n = 0;
+    for (; ! (x & 1); x >>= 1)
+        n++;
+    return n;
+#endif
+}
+
+// Append the n (<= 64) lowest bits of x to the block, most significant bit first.
+static void history_put(struct history_block *b, uint64_t x, int n) {
+    while (n > 0) {
+        const int room = 8 - (b->bits & 7);
+        const int chunk = (n < room) ? n : room;
+        const unsigned char part =
+            (unsigned char)((x >> (n - chunk)) & ((1u << chunk) - 1));
+        if ((b->bits & 7) == 0)
+            b->data[b->bits >> 3] = 0;
+        b->data[b->bits >> 3] |= (unsigned char)(part << (room - chunk));
+        b->bits += chunk;
+        n -= chunk;
+    }
+}
+
+// Read the next n (<= 64) bits of the block.
+static uint64_t history_get(const struct history_block *b, size_t *pos, int n) {
+    uint64_t x = 0;
+    while (n > 0) {
+        const int avail = 8 - (*pos & 7);
+        const int chunk = (n < avail) ? n : avail;
+        const unsigned char byte = b->data[*pos >> 3];
+        x = (x << chunk) | ((byte >> (avail - chunk)) & ((1u << chunk) - 1));
+        *pos += chunk;
+        n -= chunk;
+    }
+    return x;
+}
+
+// Read an n-bit two's complement number.
+static long long history_get_signed(const struct history_block *b, size_t *pos, int n) {
+    const uint64_t x = history_get(b, pos, n);
+    const uint64_t sign = (uint64_t)1 << (n - 1);
+    return (long long)((x ^ sign) - sign);
+}
+
+static void history_put_value(struct history_block *b, struct history_state *st, int k,
+                              double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    const uint64_t x = bits ^ st->bits[k];
+    st->bits[k] = bits;
+    if (x == 0) {
+        history_put(b, 0, 1);
+        return;
+    }
+    int leading = count_leading_zeros(x), trailing = count_trailing_zeros(x);
+    if (leading > 31)
+        leading = 31;  // stored in 5 bits
+    if (st->leading[k] >= 0 && leading >= st->leading[k] &&
+        trailing >= st->trailing[k]) {
+        // Meaningful bits fit within the previous window.
+        history_put(b, 2, 2);
+        history_put(b, x >> st->trailing[k], 64 - st->leading[k] - st->trailing[k]);
+    } else {
+        const int significant = 64 - leading - trailing;
+        history_put(b, 3, 2);
+        history_put(b, leading, 5);
+        history_put(b, significant - 1, 6);
+        history_put(b, x >> trailing, significant);
+        st->leading[k] = leading;
+        st->trailing[k] = trailing;
+    }
+}
+
+static double history_get_value(const struct history_block *b, size_t *pos,
+                                struct history_state *st, int k) {
+    if (history_get(b, pos, 1)) {
+        if (history_get(b, pos, 1)) {
+            st->leading[k] = history_get(b, pos, 5);
+            const int significant = history_get(b, pos, 6) + 1;
+            st->trailing[k] = 64 - st->leading[k] - significant;
+        }
+        const int significant = 64 - st->leading[k] - st->trailing[k];
+        st->bits[k] ^= history_get(b, pos, significant) << st->trailing[k];
+    }
+    double value;
+    memcpy(&value, &st->bits[k], sizeof(value));
+    return value;
+}
+
+// Append a record: timestamp t in milliseconds, and its `series` values.
+static void history_append(long long t, const double *record) {
+    struct history_state *st = &history_encoder;
+    struct history_block *b = NULL;
+
+    if (history_max_blocks == 0)
+        return;
+    if (history_num_blocks > 0)
+        b = history_blocks[(history_first_block + history_num_blocks - 1) %
+                           history_max_blocks];
+
+    if (b == NULL || b->bits + HISTORY_RECORD_BITS_MAX > HISTORY_BLOCK_BYTES * 8) {
+        // Start a new block, recycling the oldest one if the budget is used up.
+        if (history_num_blocks == history_max_blocks) {
+            b = history_blocks[history_first_block];
+            history_first_block = (history_first_block + 1) % history_max_blocks;
+        } else {
+            b = malloc(sizeof(*b));
+            if (b == NULL)
+                return;  // keep what we have, but do not grow
+            history_blocks[(history_first_block + history_num_blocks) %
+                           history_max_blocks] = b;
+            history_num_blocks++;
+        }
+        b->first = v;
+        b->count = 0;
+        b->bits = 0;
+        history_put(b, (uint64_t)t, 64);
+        for (int k = 0; k < series; k++) {
+            memcpy(&st->bits[k], &record[k], sizeof(st->bits[k]));
+            history_put(b, st->bits[k], 64);
+            st->leading[k] = -1;
+        }
+        st->t = t;
+        st->dt = 0;
+        b->count++;
+        return;
+    }
+
+    const long long dt = t - st->t;
+    const long long dod = dt - st->dt;
+    st->t = t;
+    st->dt = dt;
+    if (dod == 0) {
+        history_put(b, 0, 1);
+    } else if (dod >= -64 && dod < 64) {
+        history_put(b, 2, 2);
+        history_put(b, (uint64_t)dod, 7);
+    } else if (dod >= -256 && dod < 256) {
+        history_put(b, 6, 3);
+        history_put(b, (uint64_t)dod, 9);
+    } else if (dod >= -2048 && dod < 2048) {
+        history_put(b, 14, 4);
+        history_put(b, (uint64_t)dod, 12);
+    } else {
+        history_put(b, 15, 4);
+        history_put(b, (uint64_t)dod, 64);
+    }
+    for (int k = 0; k < series; k++)
+        history_put_value(b, st, k, record[k]);
+    b->count++;
+}
+
+// Decode the next record into t and record[0..series). Return false once past the
+// newest record.
+static bool history_next(struct history_reader *r, long long *t, double *record) {
+    struct history_state *st = &r->state;
+
+    if (r->block >= history_num_blocks)
+        return false;
+    const struct history_block *b =
+        history_blocks[(history_first_block + r->block) % history_max_blocks];
+    if (r->index >= b->count) {
+        r->block++;
+        r->pos = 0;
+        r->index = 0;
+        return history_next(r, t, record);
+    }
+
+    if (r->index == 0) {
+        st->t = (long long)history_get(b, &r->pos, 64);
+        st->dt = 0;
+        for (int k = 0; k < series; k++) {
+            st->bits[k] = history_get(b, &r->pos, 64);
+            st->leading[k] = -1;
+            memcpy(&record[k], &st->bits[k], sizeof(record[k]));
+        }
+    } else {
+        long long dod = 0;
+        if (history_get(b, &r->pos, 1)) {
+            if (! history_get(b, &r->pos, 1))
+                dod = history_get_signed(b, &r->pos, 7);
+            else if (! history_get(b, &r->pos, 1))
+                dod = history_get_signed(b, &r->pos, 9);
+            else if (! history_get(b, &r->pos, 1))
+                dod = history_get_signed(b, &r->pos, 12);
+            else
+                dod = (long long)history_get(b, &r->pos, 64);
+        }
+        st->dt += dod;
+        st->t += st->dt;
+        for (int k = 0; k < series; k++)
+            record[k] = history_get_value(b, &r->pos, st, k);
     }
-    if (v2) {
-        const double dv2 = *v2 - previous_v2;
-        previous_v2 = *v2;
-        if (dt <= 0)
-            *v2 = 0;
+    *t = st->t;
+    r->index++;
+    r->record++;
+    return true;
+}
+
+// Position a reader on the given record number, or on the oldest record still in
+// the history if that one is gone. Return the record number positioned at, or -1 if
+// there is nothing to read.
+static long long history_seek(struct history_reader *r, long long record) {
+    int lo = 0, hi = history_num_blocks - 1;
+
+    if (history_num_blocks == 0 || record >= v)
+        return -1;
+
+    // Find the last block starting at or before the record.
+    while (lo < hi) {
+        const int mid = (lo + hi + 1) / 2;
+        if (history_blocks[(history_first_block + mid) % history_max_blocks]->first <=
+            record)
+            lo = mid;
         else
-            *v2 = dv2 / dt;
+            hi = mid - 1;
     }
-    return dt;
+
+    const struct history_block *b =
+        history_blocks[(history_first_block + lo) % history_max_blocks];
+    r->block = lo;
+    r->pos = 0;
+    r->index = 0;
+    r->record = b->first;
+    if (record > b->first) {
+        long long t;
+        double skipped[MAX_SERIES];
+        while (r->record < record && history_next(r, &t, skipped))
+            ;
+    }
+    return r->record;
 }
 
-static void getminmax(int pw, double *values, double *min, double *max, double *avg,
-                      int v) {
-    double tot = 0;
-    int i = 0;
+// Return the values of record number i, or NULL if it is not (or no longer) stored.
+static const double *get_record(long long i) {
+    if (i < 0 || i >= v || i < v - capacity)
+        return NULL;
+    return values + (i % capacity) * series;
+}
+
+// Return value k of record number i, or NAN if it is not (or no longer) stored.
+static double get_value(int k, long long i) {
+    const double *record = get_record(i);
+    return record ? record[k] : NAN;
+}
+
+// Envelope of each column (-a envelope): the minimum and the maximum of the records
+// folded into it, `series` pairs per slot of the ring buffer, or NULL. Records brought
+// back from the history have none, and get their value as both.
+static double *envelopes = NULL;
+
+// Return the range of value k of record number i: its envelope, or just the value.
+static void get_range(int k, long long i, double *low, double *high) {
+    const double *record = get_record(i);
+    if (record == NULL) {
+        *low = *high = NAN;
+    } else if (envelopes != NULL) {
+        *low = envelopes[(i % capacity) * series * 2 + 2 * k];
+        *high = envelopes[(i % capacity) * series * 2 + 2 * k + 1];
+    } else {
+        *low = *high = record[k];
+    }
+}
+
+// Heatmap (-d): how many samples of the first series each column got per value bin,
+// HEAT_BINS counts per slot of the ring buffer, or NULL. The bins split a range of
+// f(value), where f is the identity, or log2 with -d log, into equal parts: bin b
+// covers [heat_origin + b * heat_step, heat_origin + (b + 1) * heat_step). Unless the
+// hard limits fix it, the range starts around the first sample and doubles each time
+// a sample falls outside of it, merging the bins of every column pairwise, so that it
+// always covers the samples at the finest resolution that does. Records brought back
+// from the history count as one sample.
+#define HEAT_BINS 256
+static unsigned *heat_counts = NULL;
+static unsigned heat_open[HEAT_BINS];  // the column being filled
+static double heat_origin, heat_step = 0;  // 0 until the first sample
+static bool heat_fixed = false;  // -m and -M set the range
+
+static double heat_f(double x) {
+    return (heatmap == HEAT_LOG) ? log2(x) : x;
+}
+
+// Double the range of the bins, extending it upwards or downwards.
+static void heat_widen(bool up) {
+    for (long long i = 0; i <= capacity; i++) {
+        unsigned *bins = (i < capacity) ? heat_counts + i * HEAT_BINS : heat_open;
+        if (up) {
+            for (int j = 0; j < HEAT_BINS / 2; j++)
+                bins[j] = bins[2 * j] + bins[2 * j + 1];
+            memset(bins + HEAT_BINS / 2, 0, HEAT_BINS / 2 * sizeof(unsigned));
+        } else {
+            for (int j = HEAT_BINS - 1; j >= HEAT_BINS / 2; j--)
+                bins[j] = bins[2 * j - HEAT_BINS] + bins[2 * j - HEAT_BINS + 1];
+            memset(bins, 0, HEAT_BINS / 2 * sizeof(unsigned));
+        }
+    }
+    if (! up)
+        heat_origin -= HEAT_BINS * heat_step;
+    heat_step *= 2;
+}
+
+// The bin of a value, widening the range if needed, or -1 for none.
+static int heat_bin(double x) {
+    if (isnan(x))
+        return -1;
+    if (heatmap == HEAT_LOG && x <= 0)
+        return 0;  // at the bottom, as there is no room below any positive value
+    const double f = heat_f(x);
+    if (heat_step == 0) {
+        heat_fixed = hardmax != FLT_MAX && hardmin != -FLT_MAX &&
+                     (heatmap == HEAT_LINEAR || hardmin > 0);
+        if (heat_fixed) {
+            heat_origin = heat_f(hardmin);
+            heat_step = (heat_f(hardmax) - heat_origin) / HEAT_BINS;
+        } else if (isfinite(f)) {
+            heat_step = ldexp(fmax(fabs(f), 1), -20);
+            heat_origin = f - HEAT_BINS / 2 * heat_step;
+        } else {
+            return -1;
+        }
+    }
+    while (! heat_fixed && isfinite(f) &&
+           (f < heat_origin || f >= heat_origin + HEAT_BINS * heat_step))
+        heat_widen(f >= heat_origin);
+    const double b = floor((f - heat_origin) / heat_step);
+    return (b < 0) ? 0 : (b >= HEAT_BINS) ? HEAT_BINS - 1 : (int)b;
+}
+
+static void heat_add(double x) {
+    const int b = heat_bin(x);
+    if (b >= 0)
+        heat_open[b]++;
+}
+
+// Reallocate the ring buffer to hold size records, keeping the newest ones.
+static void resize_values(int size) {
+    double *new_values = malloc((size_t)size * series * sizeof(double));
+    if (new_values == NULL) {
+        endwin();
+        fprintf(stderr, "Error: failed to allocate %d records\n", size);
+        exit(1);
+    }
+
+    double *new_envelopes = NULL;
+    if (aggregation == AGGREGATE_ENVELOPE) {
+        new_envelopes = malloc((size_t)size * series * 2 * sizeof(double));
+        if (new_envelopes == NULL) {
+            endwin();
+            fprintf(stderr, "Error: failed to allocate %d records\n", size);
+            exit(1);
+        }
+    }
+    unsigned *new_heat_counts = NULL;
+    if (heatmap != HEAT_NONE) {
+        new_heat_counts = calloc((size_t)size * HEAT_BINS, sizeof(unsigned));
+        if (new_heat_counts == NULL) {
+            endwin();
+            fprintf(stderr, "Error: failed to allocate %d records\n", size);
+            exit(1);
+        }
+    }
+
+    for (long long i = v - size; i < v; i++) {
+        double *slot = new_values + ((i + size) % size) * series;  // i may be negative
+        for (int k = 0; k < series; k++)
+            slot[k] = values ? get_value(k, i) : NAN;
+        if (new_envelopes != NULL) {
+            double *range = new_envelopes + ((i + size) % size) * series * 2;
+            for (int k = 0; k < series; k++)
+                get_range(k, i, &range[2 * k], &range[2 * k + 1]);
+        }
+        if (new_heat_counts != NULL && heat_counts != NULL && get_record(i) != NULL)
+            memcpy(new_heat_counts + ((i + size) % size) * HEAT_BINS,
+                   heat_counts + (i % capacity) * HEAT_BINS,
+                   HEAT_BINS * sizeof(unsigned));
+    }
+
+    // Records the old buffer no longer held may still be in the history.
+    struct history_reader reader;
+    long long t, i = history_seek(&reader, v - size);
+    const long long restored = i;
+    if (i >= 0) {
+        while (i < v - capacity &&
+               history_next(&reader, &t, new_values + (i % size) * series)) {
+            for (int k = 0; new_envelopes != NULL && k < series; k++)
+                new_envelopes[(i % size) * series * 2 + 2 * k] =
+                    new_envelopes[(i % size) * series * 2 + 2 * k + 1] =
+                        new_values[(i % size) * series + k];
+            i++;
+        }
+    }
+
+    free(values);
+    free(envelopes);
+    free(heat_counts);
+    values = new_values;
+    envelopes = new_envelopes;
+    heat_counts = new_heat_counts;
+    capacity = size;
+
+    // Binning restored records may widen the range of the bins of all columns.
+    for (long long j = restored; heat_counts != NULL && j >= 0 && j < i; j++) {
+        const int b = heat_bin(get_value(0, j));
+        if (b >= 0)
+            heat_counts[(j % capacity) * HEAT_BINS + b] = 1;
+    }
+}
+
+// Streaming percentiles (-P): a histogram with logarithmic buckets, as in HDR
+// histograms. The bucket of a value is its exponent and the top QUANTILE_SUB_BITS
+// bits of its mantissa, that is the top bits of its magnitude as an IEEE 754 double,
+// so that counting a value takes a shift and two increments, and its bucket is
+// within 2^-(QUANTILE_SUB_BITS + 1) of it relative to its midpoint. Magnitudes below
+// 2^QUANTILE_MIN_EXP count as zero, those from 2^(QUANTILE_MIN_EXP + QUANTILE_OCTAVES)
+// on in the last bucket. Buckets are counted per octave as well, so that finding a
+// rank walks at most one octave of buckets after the octaves before it.
+#define QUANTILE_SUB_BITS 6
+#define QUANTILE_SUBS (1 << QUANTILE_SUB_BITS)
+#define QUANTILE_MIN_EXP (-64)  // about 5e-20
+#define QUANTILE_OCTAVES 128     // up to about 2e19
+#define QUANTILE_SIDE (QUANTILE_OCTAVES * QUANTILE_SUBS)
+// Negative values with the largest first, an octave for zero, then positive values.
+#define QUANTILE_BUCKETS (2 * QUANTILE_SIDE + QUANTILE_SUBS)
+
+struct quantiles {
+    long long count;
+    long long *buckets;                                   // QUANTILE_BUCKETS
+    long long octaves[QUANTILE_BUCKETS / QUANTILE_SUBS];  // sums of their buckets
+};
+
+static int quantile_bucket(double x) {
+    const double magnitude = fabs(x);
+    uint64_t bits;
+    memcpy(&bits, &magnitude, sizeof(bits));
+    long long j = (long long)(bits >> (52 - QUANTILE_SUB_BITS)) -
+                  ((1023LL + QUANTILE_MIN_EXP) << QUANTILE_SUB_BITS);
+    if (j < 0)
+        return QUANTILE_SIDE;
+    if (j >= QUANTILE_SIDE)
+        j = QUANTILE_SIDE - 1;
+    return (x < 0) ? QUANTILE_SIDE - 1 - j : QUANTILE_SIDE + QUANTILE_SUBS + j;
+}
+
+// The value in the middle of bucket b.
+static double quantile_value(int b) {
+    if (b >= QUANTILE_SIDE && b < QUANTILE_SIDE + QUANTILE_SUBS)
+        return 0;
+    const long long j = (b < QUANTILE_SIDE) ? QUANTILE_SIDE - 1 - b
+                                            : b - QUANTILE_SIDE - QUANTILE_SUBS;
+    const uint64_t bits =
+        (uint64_t)(j + ((1023LL + QUANTILE_MIN_EXP) << QUANTILE_SUB_BITS))
+            << (52 - QUANTILE_SUB_BITS) |
+        1ULL << (51 - QUANTILE_SUB_BITS);
+    double magnitude;
+    memcpy(&magnitude, &bits, sizeof(magnitude));
+    return (b < QUANTILE_SIDE) ? -magnitude : magnitude;
+}
+
+static void quantiles_reset(struct quantiles *q) {
+    if (q->buckets == NULL)
+        q->buckets = malloc(QUANTILE_BUCKETS * sizeof(long long));
+    if (q->buckets == NULL) {
+        endwin();
+        fprintf(stderr, "Error: failed to allocate the percentiles\n");
+        exit(1);
+    }
+    memset(q->buckets, 0, QUANTILE_BUCKETS * sizeof(long long));
+    memset(q->octaves, 0, sizeof(q->octaves));
+    q->count = 0;
+}
 
-    *min = FLT_MAX;
-    *max = -FLT_MAX;
+// Count a value in (delta 1) or out (delta -1). NaN values are not counted.
+static void quantiles_add(struct quantiles *q, double x, int delta) {
+    if (isnan(x))
+        return;
+    const int b = quantile_bucket(x);
+    q->buckets[b] += delta;
+    q->octaves[b / QUANTILE_SUBS] += delta;
+    q->count += delta;
+}
+
+// The p-quantile (0 < p <= 1) of the values counted, by nearest rank, clamped to
+// [lo, hi]: their minimum and maximum if known, so that the extremes are exact.
+static double quantiles_get(const struct quantiles *q, double p, double lo, double hi) {
+    if (q->count == 0)
+        return NAN;
+    long long rank = (long long)ceil(p * q->count), seen = 0;
+    if (rank < 1)
+        rank = 1;
+    int o = 0;
+    while (seen + q->octaves[o] < rank)
+        seen += q->octaves[o++];
+    int b = o * QUANTILE_SUBS;
+    while (seen + q->buckets[b] < rank)
+        seen += q->buckets[b++];
+    const double x = quantile_value(b);
+    return (x < lo) ? lo : (x > hi) ? hi : x;
+}
+
+// Percentiles of all the input (-P session), and its extremes, per series.
+static struct quantiles session_quantiles[MAX_SERIES];
+static double session_mins[MAX_SERIES], session_maxes[MAX_SERIES];
+
+// Statistics of the visible window of a series, i.e. its last `size` records, kept
+// up to date in amortized O(1) per record: monotonic deques for the minimum and the
+// maximum, a compensated (Neumaier) running sum for the average, and with -P window
+// a histogram for the percentiles. The minimum and maximum are those of the
+// envelopes, with -a envelope.
+struct window_entry {
+    long long i;  // record number
+    double value;
+};
+
+struct window_deque {
+    struct window_entry *entries;  // ring of `size` entries
+    int head, len;
+};
+
+struct window_stats {
+    int size;                   // window length in records
+    long long start, end;       // records [start, end) are in the window
+    struct window_deque mins;   // increasing values, oldest first
+    struct window_deque maxes;  // decreasing values, oldest first
+    double sum, compensation;
+    int count;  // number of non-NaN values in the window
+    struct quantiles quantiles;
+};
+
+static struct window_stats stats[MAX_SERIES];
+
+static void add_compensated(double *sum, double *compensation, double x) {
+    const double t = *sum + x;
+    if (fabs(*sum) >= fabs(x))
+        *compensation += (*sum - t) + x;
+    else
+        *compensation += (x - t) + *sum;
+    *sum = t;
+}
+
+// Append a record to a deque after dropping the entries it supersedes, that is those
+// not below (mins) or above (maxes) the new value: they can never be reported again.
+static void window_deque_push(struct window_deque *q, int size, long long i,
+                              double value, bool is_min) {
+    while (q->len > 0) {
+        const double back = q->entries[(q->head + q->len - 1) % size].value;
+        if (is_min ? (back < value) : (back > value))
+            break;
+        q->len--;
+    }
+    q->entries[(q->head + q->len) % size] = (struct window_entry){i, value};
+    q->len++;
+}
+
+static void window_deque_evict(struct window_deque *q, int size, long long i) {
+    if (q->len > 0 && q->entries[q->head].i == i) {
+        q->head = (q->head + 1) % size;
+        q->len--;
+    }
+}
+
+// Add record number `end` to the window of series k, evicting the oldest record if the
+// window is full. Must be called before the record is stored in the ring buffer, which
+// may overwrite the evicted one.
+static void window_stats_push(struct window_stats *s, int k, double value, double low,
+                              double high) {
+    if (s->end - s->start == s->size) {
+        const double old = get_value(k, s->start);
+        window_deque_evict(&s->mins, s->size, s->start);
+        window_deque_evict(&s->maxes, s->size, s->start);
+        if (! isnan(old)) {
+            add_compensated(&s->sum, &s->compensation, -old);
+            s->count--;
+            if (percentiles == PERCENTILES_WINDOW)
+                quantiles_add(&s->quantiles, old, -1);
+        }
+        s->start++;
+    }
+    if (! isnan(value)) {
+        window_deque_push(&s->mins, s->size, s->end, low, true);
+        window_deque_push(&s->maxes, s->size, s->end, high, false);
+        add_compensated(&s->sum, &s->compensation, value);
+        s->count++;
+        if (percentiles == PERCENTILES_WINDOW)
+            quantiles_add(&s->quantiles, value, 1);
+    }
+    s->end++;
+}
+
+// Recompute the statistics of the last `size` records of series k from scratch.
+static void window_stats_rebuild(struct window_stats *s, int k, int size) {
+    struct quantiles q = s->quantiles;
+    free(s->mins.entries);
+    free(s->maxes.entries);
+    *s = (struct window_stats){.size = size, .quantiles = q};
+    if (percentiles == PERCENTILES_WINDOW)
+        quantiles_reset(&s->quantiles);
+    s->mins.entries = malloc(size * sizeof(struct window_entry));
+    s->maxes.entries = malloc(size * sizeof(struct window_entry));
+    if (s->mins.entries == NULL || s->maxes.entries == NULL) {
+        endwin();
+        fprintf(stderr, "Error: failed to allocate %d records\n", size);
+        exit(1);
+    }
+    s->start = s->end = (v > size) ? v - size : 0;
+    while (s->end < v) {
+        double low, high;
+        get_range(k, s->end, &low, &high);
+        window_stats_push(s, k, get_value(k, s->end), low, high);
+    }
+}
+
+static void window_stats_get(const struct window_stats *s, double *min, double *max,
+                             double *avg) {
+    *min = (s->mins.len > 0) ? s->mins.entries[s->mins.head].value : FLT_MAX;
+    *max = (s->maxes.len > 0) ? s->maxes.entries[s->maxes.head].value : -FLT_MAX;
+    *avg = (s->sum + s->compensation) / s->count;
+}
+
+// How values map to rows of the plot: (int)lrint(frac * scale) of the fraction
+// frac = (value - min) / range of the way from min to max, clamped to [lo, hi].
+struct row_map {
+    double min, range, lo, hi, scale;
+};
+
+static inline int value_row(double value, const struct row_map *m) {
+    double frac = (value - m->min) / m->range;
+    if (frac < m->lo)
+        frac = m->lo;
+    if (frac > m->hi)
+        frac = m->hi;
+    return lrint(frac * m->scale);
+}
+
+static void value_rows_scalar(const double *x, int n, const struct row_map *m,
+                              int *rows) {
+    for (int j = 0; j < n; j++)
+        rows[j] = value_row(x[j], m);
+}
+
+// The vector kernels round the same way lrint() does, in the current rounding mode.
+// NaN and rows beyond the range of int convert to INT_MIN, and are left to
+// value_row(), so that all results match the scalar ones exactly.
+#ifdef X86_SIMD
+static void value_rows_sse2(const double *x, int n, const struct row_map *m,
+                            int *rows) {
+    const __m128d min = _mm_set1_pd(m->min), range = _mm_set1_pd(m->range);
+    const __m128d lo = _mm_set1_pd(m->lo), hi = _mm_set1_pd(m->hi);
+    const __m128d scale = _mm_set1_pd(m->scale);
+    const __m128i invalid = _mm_set1_epi32(INT_MIN);
+    int j = 0;
+
+    for (; j + 2 <= n; j += 2) {
+        const __m128d value = _mm_loadu_pd(x + j);
+        __m128d frac = _mm_div_pd(_mm_sub_pd(value, min), range);
+        frac = _mm_min_pd(_mm_max_pd(frac, lo), hi);
+        const __m128i row = _mm_cvtpd_epi32(_mm_mul_pd(frac, scale));
+        _mm_storel_epi64((__m128i *)(rows + j), row);
+        if (_mm_movemask_pd(_mm_cmpunord_pd(value, value)) |
+            (_mm_movemask_epi8(_mm_cmpeq_epi32(row, invalid)) & 0xff)) {
+            rows[j] = value_row(x[j], m);
+            rows[j + 1] = value_row(x[j + 1], m);
+        }
+    }
+    value_rows_scalar(x + j, n - j, m, rows + j);
+}
+
+__attribute__((target("avx2"))) static void value_rows_avx2(const double *x, int n,
+                                                            const struct row_map *m,
+                                                            int *rows) {
+    const __m256d min = _mm256_set1_pd(m->min), range = _mm256_set1_pd(m->range);
+    const __m256d lo = _mm256_set1_pd(m->lo), hi = _mm256_set1_pd(m->hi);
+    const __m256d scale = _mm256_set1_pd(m->scale);
+    const __m128i invalid = _mm_set1_epi32(INT_MIN);
+    int j = 0;
+
+    for (; j + 4 <= n; j += 4) {
+        const __m256d value = _mm256_loadu_pd(x + j);
+        __m256d frac = _mm256_div_pd(_mm256_sub_pd(value, min), range);
+        frac = _mm256_min_pd(_mm256_max_pd(frac, lo), hi);
+        const __m128i row = _mm256_cvtpd_epi32(_mm256_mul_pd(frac, scale));
+        _mm_storeu_si128((__m128i *)(rows + j), row);
+        if (_mm256_movemask_pd(_mm256_cmp_pd(value, value, _CMP_UNORD_Q)) |
+            _mm_movemask_epi8(_mm_cmpeq_epi32(row, invalid)))
+            value_rows_scalar(x + j, 4, m, rows + j);
+    }
+    value_rows_scalar(x + j, n - j, m, rows + j);
+}
+#endif
 
-    for (i = 0; i < pw && i < v; i++) {
-        if (values[i] > *max)
-            *max = values[i];
+static void value_rows_resolve(const double *x, int n, const struct row_map *m,
+                               int *rows);
+
+// Map n values to rows, using the best implementation this CPU supports.
+static void (*value_rows)(const double *x, int n, const struct row_map *m,
+                          int *rows) = value_rows_resolve;
+
+static void value_rows_resolve(const double *x, int n, const struct row_map *m,
+                               int *rows) {
+    value_rows = value_rows_scalar;
+#ifdef X86_SIMD
+    value_rows = value_rows_sse2;
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        value_rows = value_rows_avx2;
+#endif
+    value_rows(x, n, m, rows);
+}
 
-        if (values[i] < *min)
-            *min = values[i];
+// Scratch space of the renderers: values of a series gathered out of the ring buffer,
+// and the rows they map to.
+static double *scratch_values = NULL;
+static int *scratch_rows = NULL;
+static int scratch_size = 0, scratch_rows_size = 0;
 
-        tot = tot + values[i];
+static bool reserve_scratch(int values_size, int rows_size) {
+    if (values_size > scratch_size) {
+        double *p = realloc(scratch_values, (size_t)values_size * sizeof(double));
+        if (p == NULL)
+            return false;
+        scratch_values = p;
+        scratch_size = values_size;
+    }
+    if (rows_size > scratch_rows_size) {
+        int *p = realloc(scratch_rows, (size_t)rows_size * sizeof(int));
+        if (p == NULL)
+            return false;
+        scratch_rows = p;
+        scratch_rows_size = rows_size;
     }
+    return true;
+}
+
+// What series_rows() maps to rows.
+enum row_source {
+    ROWS_VALUE,     // the values
+    ROWS_MIDPOINT,  // their midpoints with the next record if that came and is not NaN
+    ROWS_LOW,       // the bottoms of their envelopes, see get_range()
+    ROWS_HIGH       // the tops
+};
 
-    *avg = tot / i;
+// Map value k of records [first, first + n) to rows. Records no longer stored count
+// as NaN.
+static void series_rows(int k, long long first, int n, enum row_source source,
+                        const struct row_map *m, int *rows) {
+    for (int j = 0; j < n; j++) {
+        if (source == ROWS_LOW || source == ROWS_HIGH) {
+            double low, high;
+            get_range(k, first + j, &low, &high);
+            scratch_values[j] = (source == ROWS_LOW) ? low : high;
+            continue;
+        }
+        const double *cur = get_record(first + j);
+        const double *next = (source == ROWS_MIDPOINT && first + j + 1 < v)
+                                 ? get_record(first + j + 1)
+                                 : NULL;
+        double val = cur ? cur[k] : NAN;
+        if (next != NULL && ! isnan(next[k]))
+            val = (val + next[k]) / 2;
+        scratch_values[j] = val;
+    }
+    value_rows(scratch_values, n, m, rows);
 }
 
 static void draw_axes(int h, int ph, int pw, double max, double min, char *unit) {
@@ -291,171 +1217,258 @@ static void draw_axes(int h, int ph, int pw, double max, double min, char *unit)
 
         double label_val;
 
-        label_val = min / 4 + max * 3 / 4;
+        label_val = (heatmap == HEAT_LOG) ? min * pow(max / min, 0.75)
+                                          : min / 4 + max * 3 / 4;
         if (fabs(label_val) < 0.01)
             label_val = 0.0;  // Prevent -0.0
         mvprintw((ph / 4) + 1, 4, "%.1f %s", label_val, unit);
 
-        label_val = min / 2 + max / 2;
+        label_val = (heatmap == HEAT_LOG) ? min * pow(max / min, 0.5)
+                                          : min / 2 + max / 2;
         if (fabs(label_val) < 0.01)
             label_val = 0.0;  // Prevent -0.0
         mvprintw((ph / 2) + 1, 4, "%.1f %s", label_val, unit);
 
-        label_val = min * 3 / 4 + max / 4;
+        label_val = (heatmap == HEAT_LOG) ? min * pow(max / min, 0.25)
+                                          : min * 3 / 4 + max / 4;
         if (fabs(label_val) < 0.01)
             label_val = 0.0;  // Prevent -0.0
         mvprintw((ph * 3 / 4) + 1, 4, "%.1f %s", label_val, unit);
     }
 
+    // Time-based X axis (-T): the interval of a column, at the end of the axis.
+    if (bucket_interval > 0) {
+        char label[32];
+        const int length =
+            snprintf(label, sizeof(label), " %gs/column ", bucket_interval);
+        if (length < pw - 1)
+            mvaddstr(h - 3, 2 + pw - length, label);
+    }
+
     if (colors[TEXT_COLOR] != -1)
         attroff(COLOR_PAIR(TEXT_COLOR + 1));
 }
 
-static void draw_line(int x, int ph, int l1, int l2, cchar_t *c1, cchar_t *c2,
-                      cchar_t *hce, cchar_t *lce, int zero_pos, double v1, double v2,
-                      int has_v2) {
-    static cchar_t space = {.attr = A_REVERSE, .chars = {' ', '\0'}};
-    cchar_t c1r = *c1, c2r = *c2;
-    c1r.attr |= A_REVERSE;
-    c2r.attr |= A_REVERSE;
-
-    // Apply appropriate colors based on character type
-    if (c1 == hce && colors[MAX_ERROR_COLOR] != -1) {
-        // Max error indicator
-        c1->attr |= COLOR_PAIR(MAX_ERROR_COLOR + 1);
-        c1r.attr |= COLOR_PAIR(MAX_ERROR_COLOR + 1);
-    } else if (c1 == lce && colors[MIN_ERROR_COLOR] != -1) {
-        // Min error indicator
-        c1->attr |= COLOR_PAIR(MIN_ERROR_COLOR + 1);
-        c1r.attr |= COLOR_PAIR(MIN_ERROR_COLOR + 1);
-    } else if (colors[LINE_COLOR] != -1) {
-        // Normal plot line
-        c1->attr |= COLOR_PAIR(LINE_COLOR + 1);
-        c1r.attr |= COLOR_PAIR(LINE_COLOR + 1);
-    }
-
-    if (c2 == hce && colors[MAX_ERROR_COLOR] != -1) {
-        // Max error indicator
-        c2->attr |= COLOR_PAIR(MAX_ERROR_COLOR + 1);
-        c2r.attr |= COLOR_PAIR(MAX_ERROR_COLOR + 1);
-    } else if (c2 == lce && colors[MIN_ERROR_COLOR] != -1) {
-        // Min error indicator
-        c2->attr |= COLOR_PAIR(MIN_ERROR_COLOR + 1);
-        c2r.attr |= COLOR_PAIR(MIN_ERROR_COLOR + 1);
-    } else if (colors[LINE_COLOR] != -1) {
-        // Normal plot line
-        c2->attr |= COLOR_PAIR(LINE_COLOR + 1);
-        c2r.attr |= COLOR_PAIR(LINE_COLOR + 1);
-    }
-
-    // Space always uses plot line color
-    if (colors[LINE_COLOR] != -1) {
-        space.attr |= COLOR_PAIR(LINE_COLOR + 1);
-    }
-
-    // Handle drawing based on whether values are positive or negative
-    if (zero_pos > 0) {  // We have negative values
-        int y1_start, y1_end;
-        int y2_start, y2_end;
-        int zero_line = ph + 1 - zero_pos;
-
-        // Calculate ranges for value 1
-        if (v1 > 0) {
-            y1_start = ph + 1 - l1;
-            y1_end = zero_line;
-        } else if (v1 < 0) {
-            y1_start = zero_line;
-            y1_end = ph + 1 - l1;
-        } else {
-            y1_start = zero_line;
-            y1_end = zero_line;
-        }
-
-        // Calculate ranges for value 2
-        if (has_v2) {
-            if (v2 > 0) {
-                y2_start = ph + 1 - l2;
-                y2_end = zero_line;
-            } else if (v2 < 0) {
-                y2_start = zero_line;
-                y2_end = ph + 1 - l2;
-            } else {
-                y2_start = zero_line;
-                y2_end = zero_line;
-            }
-        } else {
-            y2_start = y2_end = -1;
-        }
+// The cells of the ASCII plot, indexed by what a value is drawn as: the plot
+// character, or the error one for exceeding hardmax or hardmin. The colors are
+// applied here once per frame, not for every column.
+enum { GLYPH_PLOT, GLYPH_MAX_ERROR, GLYPH_MIN_ERROR, NUM_GLYPHS };
+struct plot_glyphs {
+    cchar_t line[NUM_GLYPHS];     // the first series
+    cchar_t reverse[NUM_GLYPHS];  // the second series, and where both overlap
+    cchar_t above[NUM_GLYPHS];    // the second series beyond the first one
+};
 
-        if (has_v2 && y2_start != -1) {
-            int overlap_start = (y1_start > y2_start) ? y1_start : y2_start;
-            int overlap_end = (y1_end < y2_end) ? y1_end : y2_end;
+static void make_plot_glyphs(struct plot_glyphs *g, const cchar_t *pc,
+                             const cchar_t *hce, const cchar_t *lce) {
+    const cchar_t *base[NUM_GLYPHS] = {pc, hce, lce};
+    const int error_colors[NUM_GLYPHS] = {-1, MAX_ERROR_COLOR, MIN_ERROR_COLOR};
+    const attr_t line_pair =
+        (colors[LINE_COLOR] != -1) ? COLOR_PAIR(LINE_COLOR + 1) : A_NORMAL;
+
+    for (int i = 0; i < NUM_GLYPHS; i++) {
+        attr_t pair = line_pair;
+        if (error_colors[i] != -1 && colors[error_colors[i]] != -1)
+            pair = COLOR_PAIR(error_colors[i] + 1);
+        g->line[i] = g->reverse[i] = *base[i];
+        g->line[i].attr |= pair;
+        g->reverse[i].attr |= A_REVERSE | pair;
+        g->above[i] = g->reverse[i];
+    }
+    // Where the second series is above the first one, only errors show their character.
+    g->above[GLYPH_PLOT] =
+        (cchar_t){.attr = A_REVERSE | line_pair, .chars = {' ', '\0'}};
+}
 
-            if (y1_start < y2_start) {
-                mvvline_set(y1_start, x, c1, y2_start - y1_start);
-            } else if (y2_start < y1_start) {
-                mvvline_set(y2_start, x, (c2 == hce || c2 == lce) ? &c2r : &space,
-                            y1_start - y2_start);
-            }
+// Rows from the zero line up or down to the level l of value val, in drawing order.
+static inline void zero_span(double val, int l, int ph, int zero_line, int *start,
+                             int *end) {
+    if (val > 0) {
+        *start = ph + 1 - l;
+        *end = zero_line;
+    } else if (val < 0) {
+        *start = zero_line;
+        *end = ph + 1 - l;
+    } else {
+        *start = zero_line;
+        *end = zero_line;
+    }
+}
 
-            if (overlap_start <= overlap_end) {
-                mvvline_set(overlap_start, x, &c2r, overlap_end - overlap_start + 1);
-            }
+// The ASCII plot area is kept in a pad whose column i % pw holds record number i, so
+// a new record only needs its own column drawn. The pad is copied to the screen
+// rotated such that the newest record ends up in the rightmost column.
+// Everything is redrawn only when the scale or the plot size changes.
+static WINDOW *plot_pad = NULL;
+static int pad_ph = -1, pad_pw = -1;  // state the pad was drawn for
+static long long pad_v = 0;
+static double pad_max, pad_min;
+
+// Series beyond the second one are drawn as a mark at their level in each column.
+static const char series_marks[MAX_SERIES - 2] = "3456789abcdefg";
+
+// What plot_columns() needs to know about the frame.
+struct plot_frame {
+    struct plot_glyphs glyphs;
+    int ph, pw, zero_pos;
+    double max, min, hardmax, hardmin;
+    const int *rows;  // [k * count + i - first]: row of value k of record number i
+    int count;
+};
 
-            if (y1_end > y2_end) {
-                mvvline_set(y2_end + 1, x, c1, y1_end - y2_end);
-            } else if (y2_end > y1_end) {
-                mvvline_set(y1_end + 1, x, (c2 == hce || c2 == lce) ? &c2r : &space,
-                            y2_end - y1_end);
-            }
+// Draw the first two series of records from number first on into plot_pad, one
+// column each, with the cells precomputed for the frame. The flags tell whether
+// there is a second series, whether values can exceed the hard limits, and whether
+// the range includes negative values.
+static void plot_columns(const struct plot_frame *f, long long first, const bool two,
+                         const bool limits, const bool is_signed) {
+    const struct plot_glyphs *g = &f->glyphs;
+    const int ph = f->ph, zero_line = ph + 1 - f->zero_pos;
+    const int *rows = f->rows;
+
+    for (long long i = first; i < v; i++) {
+        const double *record = get_record(i);
+        if (record == NULL)
+            continue;
+        const double val1 = record[0];
+        const double val2 = two ? record[1] : NAN;
+        const int x = i % f->pw;
+        int l1, l2, kind1 = GLYPH_PLOT, kind2 = GLYPH_PLOT;
+
+        /* suppress drawing uninitialized entries */
+        if (isnan(val1))
+            continue;
+
+        if (limits && val1 > f->hardmax) {
+            l1 = ph;
+            kind1 = GLYPH_MAX_ERROR;
+        } else if (limits && val1 < f->hardmin) {
+            l1 = 1;
+            kind1 = GLYPH_MIN_ERROR;
         } else {
-            if (y1_start < y1_end) {
-                mvvline_set(y1_start, x, c1, y1_end - y1_start + 1);
-            } else if (y1_start > y1_end) {
-                mvvline_set(y1_end, x, c1, y1_start - y1_end + 1);
-            } else {
-                mvvline_set(y1_start, x, c1, 1);
+            l1 = rows[i - first];
+        }
+
+        if (! two || isnan(val2)) {
+            if (is_signed) {
+                int start, end;
+                zero_span(val1, l1, ph, zero_line, &start, &end);
+                if (start > end)
+                    mvwvline_set(plot_pad, end, x, &g->line[kind1], start - end + 1);
+                else
+                    mvwvline_set(plot_pad, start, x, &g->line[kind1], end - start + 1);
+            } else if (l1 > 0) {
+                mvwvline_set(plot_pad, ph + 1 - l1, x, &g->line[kind1], l1);
             }
+            continue;
         }
-    } else {
-        // Original behavior for all positive values
-        if (l1 > l2) {
-            mvvline_set(ph + 1 - l1, x, c1, l1 - l2);
-            mvvline_set(ph + 1 - l2, x, &c2r, l2);
+
+        if (limits && val2 > f->hardmax) {
+            l2 = ph;
+            kind2 = GLYPH_MAX_ERROR;
+        } else if (limits && val2 < f->hardmin) {
+            l2 = 1;
+            kind2 = GLYPH_MIN_ERROR;
+        } else {
+            l2 = rows[f->count + i - first];
+        }
+
+        if (is_signed) {
+            int y1_start, y1_end, y2_start, y2_end;
+            zero_span(val1, l1, ph, zero_line, &y1_start, &y1_end);
+            zero_span(val2, l2, ph, zero_line, &y2_start, &y2_end);
+            const int overlap_start = (y1_start > y2_start) ? y1_start : y2_start;
+            const int overlap_end = (y1_end < y2_end) ? y1_end : y2_end;
+
+            if (y1_start < y2_start)
+                mvwvline_set(plot_pad, y1_start, x, &g->line[kind1],
+                             y2_start - y1_start);
+            else if (y2_start < y1_start)
+                mvwvline_set(plot_pad, y2_start, x, &g->above[kind2],
+                             y1_start - y2_start);
+            if (overlap_start <= overlap_end)
+                mvwvline_set(plot_pad, overlap_start, x, &g->reverse[kind2],
+                             overlap_end - overlap_start + 1);
+            if (y1_end > y2_end)
+                mvwvline_set(plot_pad, y2_end + 1, x, &g->line[kind1], y1_end - y2_end);
+            else if (y2_end > y1_end)
+                mvwvline_set(plot_pad, y1_end + 1, x, &g->above[kind2],
+                             y2_end - y1_end);
+        } else if (l1 > l2) {
+            mvwvline_set(plot_pad, ph + 1 - l1, x, &g->line[kind1], l1 - l2);
+            mvwvline_set(plot_pad, ph + 1 - l2, x, &g->reverse[kind2], l2);
         } else if (l1 < l2) {
-            mvvline_set(ph + 1 - l2, x, (c2 == hce || c2 == lce) ? &c2r : &space,
-                        l2 - l1);
-            mvvline_set(ph + 1 - l1, x, &c2r, l1);
+            mvwvline_set(plot_pad, ph + 1 - l2, x, &g->above[kind2], l2 - l1);
+            mvwvline_set(plot_pad, ph + 1 - l1, x, &g->reverse[kind2], l1);
         } else {
-            mvvline_set(ph + 1 - l2, x, &c2r, l2);
+            mvwvline_set(plot_pad, ph + 1 - l2, x, &g->reverse[kind2], l2);
         }
     }
+}
 
-    // Reset all color attributes (COLOR_PAIR indexes are LINE_COLOR+1 through
-    // MIN_ERROR_COLOR+1)
-    const attr_t color_mask = COLOR_PAIR(LINE_COLOR + 1) |
-                              COLOR_PAIR(MAX_ERROR_COLOR + 1) |
-                              COLOR_PAIR(MIN_ERROR_COLOR + 1);
-
-    c1->attr &= ~color_mask;
-    c2->attr &= ~color_mask;
-    c1r.attr &= ~color_mask;
-    c2r.attr &= ~color_mask;
-
-    if (colors[LINE_COLOR] != -1) {
-        space.attr &= ~COLOR_PAIR(LINE_COLOR + 1);
+// Draw the envelopes of the first two series of records from number first on into
+// plot_pad (-a envelope): a bar from the minimum to the maximum of each column, in
+// reverse video for the second series, and in the error glyph where it goes beyond a
+// hard limit. Their rows follow those of the values in f->rows, low then high.
+static void plot_envelopes(const struct plot_frame *f, long long first) {
+    const int *rows = f->rows + series * f->count;
+
+    for (long long i = first; i < v; i++) {
+        for (int k = 0; k < series && k < 2; k++) {
+            double low, high;
+            get_range(k, i, &low, &high);
+            if (isnan(low) || isnan(high))
+                continue;
+            const int kind = (high > f->hardmax)  ? GLYPH_MAX_ERROR
+                             : (low < f->hardmin) ? GLYPH_MIN_ERROR
+                                                  : GLYPH_PLOT;
+            int lo = rows[(2 * k) * f->count + i - first];
+            int hi = rows[(2 * k + 1) * f->count + i - first];
+            lo = (lo < 1) ? 1 : (lo > f->ph) ? f->ph : lo;
+            hi = (hi < 1) ? 1 : (hi > f->ph) ? f->ph : hi;
+            mvwvline_set(plot_pad, f->ph + 1 - hi, i % f->pw,
+                         (k == 0) ? &f->glyphs.line[kind] : &f->glyphs.reverse[kind],
+                         hi - lo + 1);
+        }
     }
 }
 
-static void plot_values(int ph, int pw, double *v1, double *v2, double max, double min,
-                        int n, cchar_t *pc, cchar_t *hce, cchar_t *lce, double hardmax,
-                        double hardmin) {
+static void plot_values(int ph, int pw, double max, double min, cchar_t *pc,
+                        cchar_t *hce, cchar_t *lce, double hardmax, double hardmin) {
+    static const cchar_t blank = {.attr = A_NORMAL, .chars = {' ', '\0'}};
     const int first_col = 3;
-    int i = (n + 1) % pw;
-    int x;
-    int l1, l2;
+    const int last = (v + pw - 1) % pw;  // column of the newest record
+    struct plot_frame frame;
+    long long i, first;
+    int k, count;
     int zero_pos = 0;
 
+    if (plot_pad == NULL || ph != pad_ph || pw != pad_pw) {
+        if (plot_pad != NULL)
+            delwin(plot_pad);
+        plot_pad = newpad(ph + 1, pw);  // row 0 unused, so pad rows match screen rows
+        if (plot_pad == NULL)
+            return;
+        pad_ph = ph;
+        pad_pw = pw;
+        pad_v = -pw;  // force a full redraw
+    }
+    if (! reserve_scratch(pw, pw * (series + 4)))
+        return;
+
+    if (max != pad_max || min != pad_min || v - pad_v >= pw) {
+        werase(plot_pad);
+        count = pw;
+    } else {
+        count = v - pad_v;
+        for (k = 0; k < count; k++)
+            mvwvline_set(plot_pad, 1, (pad_v + k) % pw, &blank, ph);
+    }
+    first = (v - count < 0) ? 0 : v - count;
+    pad_max = max;
+    pad_min = min;
+    pad_v = v;
+
     // Calculate zero position if we have negative values
     if (min < 0 && max > 0) {
         zero_pos = lrint((0 - min) / (max - min) * ph);
@@ -463,43 +1476,66 @@ static void plot_values(int ph, int pw, double *v1, double *v2, double max, doub
         zero_pos = ph;  // All values are negative, zero is at top
     }
 
-    if (colors[LINE_COLOR] != -1)
-        attron(COLOR_PAIR(LINE_COLOR + 1));
-
-    for (x = first_col; x < first_col + pw; x++, i = (i + 1) % pw) {
-        /* suppress drawing uninitialized entries */
-        if (! v1 || isnan(v1[i]))
-            continue;
+    make_plot_glyphs(&frame.glyphs, pc, hce, lce);
+    frame.ph = ph;
+    frame.pw = pw;
+    frame.zero_pos = zero_pos;
+    frame.max = max;
+    frame.min = min;
+    frame.hardmax = hardmax;
+    frame.hardmin = hardmin;
+    frame.rows = scratch_rows;
+    frame.count = v - first;
+
+    // The rows of all values to draw, from the first series on.
+    const struct row_map map = {min, max - min, -INFINITY, INFINITY, ph};
+    for (k = 0; k < series; k++)
+        series_rows(k, first, frame.count, ROWS_VALUE, &map,
+                    scratch_rows + k * frame.count);
+    for (k = 0; envelopes != NULL && k < series && k < 2; k++) {
+        series_rows(k, first, frame.count, ROWS_LOW, &map,
+                    scratch_rows + (series + 2 * k) * frame.count);
+        series_rows(k, first, frame.count, ROWS_HIGH, &map,
+                    scratch_rows + (series + 2 * k + 1) * frame.count);
+    }
 
-        if (v1[i] > hardmax)
-            l1 = ph;
-        else if (v1[i] < hardmin)
-            l1 = 1;
-        else
-            l1 = lrint((v1[i] - min) / (max - min) * ph);
+    if (colors[LINE_COLOR] != -1)
+        wattron(plot_pad, COLOR_PAIR(LINE_COLOR + 1));
 
-        if (! v2 || isnan(v2[i]))
-            l2 = 0;
-        else if (v2[i] > hardmax)
-            l2 = ph;
-        else if (v2[i] < hardmin)
-            l2 = 1;
-        else
-            l2 = lrint((v2[i] - min) / (max - min) * ph);
+    // The scale covers all values in view, so no value can exceed the hard limits
+    // unless they are the scale.
+    if (envelopes != NULL)
+        plot_envelopes(&frame, first);
+    else
+        plot_columns(&frame, first, series > 1, max >= hardmax || min <= hardmin,
+                     zero_pos > 0);
 
-        draw_line(x, ph, l1, l2,
-                  (v1[i] > hardmax)   ? hce
-                  : (v1[i] < hardmin) ? lce
-                                      : pc,
-                  (v2 && v2[i] > hardmax)   ? hce
-                  : (v2 && v2[i] < hardmin) ? lce
-                                            : pc,
-                  hce, lce, zero_pos, v1[i], (v2 && ! isnan(v2[i])) ? v2[i] : 0,
-                  (v2 && ! isnan(v2[i])));
+    for (i = first; series > 2 && i < v; i++) {
+        const double *record = get_record(i);
+        if (record == NULL || isnan(record[0]))
+            continue;
+        for (int j = 2; j < series; j++) {
+            const double val = record[j];
+            if (isnan(val))
+                continue;
+            int l = scratch_rows[j * frame.count + i - first];
+            if (l < 1)
+                l = 1;
+            if (l > ph)
+                l = ph;
+            mvwaddch(plot_pad, ph + 1 - l, i % pw, series_marks[j - 2] | A_BOLD);
+        }
     }
 
     if (colors[LINE_COLOR] != -1)
-        attroff(COLOR_PAIR(LINE_COLOR + 1));
+        wattroff(plot_pad, COLOR_PAIR(LINE_COLOR + 1));
+
+    // Oldest slots first, then the ones up to and including the newest.
+    if (last + 1 < pw)
+        copywin(plot_pad, stdscr, 1, last + 1, 1, first_col, ph,
+                first_col + pw - last - 2, FALSE);
+    copywin(plot_pad, stdscr, 1, 0, 1, first_col + pw - last - 1, ph,
+            first_col + pw - 1, FALSE);
 }
 
 // braille (2x4) bits indexed [(y%4)*2 + (x&1)]; quadrant (2x2) bits indexed [(y%2)*2 +
@@ -511,93 +1547,271 @@ static const wchar_t quad_glyphs[16] = {L' ',   0x2598, 0x259D, 0x2580, 0x2596,
                                         0x259E, 0x259B, 0x2597, 0x259A, 0x2590, 0x259C,
                                         0x2584, 0x2599, 0x259F, 0x2588};
 
-// Render v1/v2 onto a sub-cell pixel grid (sub vertical pixels per cell, 2 horizontal).
-// glyphs==NULL selects braille (U+2800+bits); otherwise a 16-entry quadrant table.
-static void plot_dots(int ph, int pw, double *v1, double *v2, double max, double min,
-                      int n, int sub, const unsigned char *bits,
-                      const wchar_t *glyphs) {
-    const int first_col = 3;
-    const int dh = ph * sub, dw = pw * 2;
-
-    if (ph <= 0 || pw <= 0)
-        return;
-
-    double range = max - min;
-    if (range <= 0)
-        range = 1;
-
-    unsigned char *canvas = calloc((size_t)ph * pw, 1);
-    unsigned char *owner = calloc((size_t)ph * pw, 1);
-    if (! canvas || ! owner) {
-        free(canvas);
-        free(owner);
-        return;
-    }
+// The braille/block plot area is kept the way the ASCII one is (see plot_values()): a
+// circular sub-pixel canvas whose column i % pw holds the dots of record number i,
+// mirrored as glyphs into a pad that is copied to the screen rotated. A column depends
+// on its neighbours through the joining segments, so a new record needs its own
+// column rasterized, and those of the previous newest record and of the oldest one
+// in view again. Everything is redrawn only when the scale or the plot size changes.
+static WINDOW *dots_pad = NULL;
+static unsigned char *dots_canvas = NULL, *dots_owner = NULL;  // ph cells per column
+static int dots_ph = -1, dots_pw = -1, dots_sub = -1;  // state the pad was drawn for
+static long long dots_v = 0;
+static double dots_max, dots_min;
+
+// The glyph of each cell, indexed [owner - 1][bits]: owner is the highest series
+// (plus one) with a dot in the cell, and gets the color.
+static cchar_t *dots_glyphs = NULL;
+static int glyphs_sub = -1, glyphs_series = 0;  // state the table was made for
+
+static bool make_dots_glyphs(int sub, const wchar_t *glyphs) {
+    const int masks = (sub == 4) ? 256 : 16;
+    if (dots_glyphs != NULL && glyphs_sub == sub && glyphs_series == series)
+        return true;
+    free(dots_glyphs);
+    dots_glyphs = malloc(series * masks * sizeof(cchar_t));
+    if (dots_glyphs == NULL)
+        return false;
+    for (int k = 0; k < series; k++)
+        for (int b = 0; b < masks; b++) {
+            wchar_t ws[2] = {glyphs ? glyphs[b] : (wchar_t)(0x2800 + b), 0};
+            setcchar(&dots_glyphs[k * masks + b], ws, A_NORMAL, PAIR_BR1 + k, NULL);
+        }
+    glyphs_sub = sub;
+    glyphs_series = series;
+    return true;
+}
 
-    for (int pass = 0; pass < 2; pass++) {
-        double *vals = (pass == 0) ? v1 : v2;
-        unsigned char who = (pass == 0) ? 1 : 2;
-        int do_fill = (pass == 0) ? braille_fill : 0;
-        if (! vals)
-            continue;
+// Sub-pixel rows of a plot dh dots high, counted from the bottom.
+static struct row_map dot_map(int dh, double max, double min) {
+    return (struct row_map){min, (max - min > 0) ? max - min : 1, 0, 1, dh - 1};
+}
 
-        int prev_y = 0;
-        bool prev_valid = false;
-        for (int x = 0; x < dw; x++) {
-            int a = x / 2;
-            double va = vals[(n + 1 + a) % pw];
-            if (isnan(va)) {
-                prev_valid = false;
-                continue;
-            }
-            double v = va;
-            if ((x & 1) && a + 1 < pw) {
-                double vb = vals[(n + 1 + a + 1) % pw];
-                if (! isnan(vb))
-                    v = (va + vb) / 2;
-            }
-            double frac = (v - min) / range;
-            if (frac < 0)
-                frac = 0;
-            if (frac > 1)
-                frac = 1;
-            int y = (dh - 1) - (int)lrint(frac * (dh - 1));
+// Sub-pixel rows, counted from the bottom, of the values of records from number
+// `base` on, of their midpoints with the next record, and with -a envelope of the
+// bottoms and tops of their envelopes, see series_rows().
+struct dot_rows {
+    long long base;
+    int n;  // records per series
+    const int *value, *midpoint, *low, *high;  // [k * n + i - base] for record i
+};
+
+// Rasterize the column of record i into the canvas and the pad, for records from
+// number `oldest` on in view. It has two dots per series: the value of record i, and
+// its midpoint with record i + 1 once that came. Each dot is joined to the previous
+// one, which for the first is the second of record i - 1, unless out of view. With
+// -a envelope, both dots stretch instead into a bar over the envelope of record i.
+static void dots_column(long long i, long long oldest, int ph, int pw, int sub,
+                        const unsigned char *bits, const struct dot_rows *rows) {
+    static const cchar_t blank = {.attr = A_NORMAL, .chars = {' ', '\0'}};
+    const int dh = ph * sub, col = i % pw, masks = (sub == 4) ? 256 : 16;
+    unsigned char *canvas = dots_canvas + (size_t)col * ph;
+    unsigned char *owner = dots_owner + (size_t)col * ph;
+    const double *prev = (i > oldest) ? get_record(i - 1) : NULL;
+    const double *cur = get_record(i);
+    const int j = i - rows->base;
+
+    memset(canvas, 0, ph);
+    memset(owner, 0, ph);
+    for (int k = 0; cur != NULL && k < series; k++) {
+        if (isnan(cur[k]))
+            continue;
+        const unsigned char who = k + 1;
+        const bool fill = (k == 0) && braille_fill;
+        const bool joined = prev != NULL && ! isnan(prev[k]);
+        const int *value = rows->value + k * rows->n;
+        const int *mid = rows->midpoint + k * rows->n;
+        int prev_y = joined ? (dh - 1) - mid[j - 1] : 0;
+        for (int half = 0; half < 2; half++) {
+            const int y = (dh - 1) - ((half == 0) ? value[j] : mid[j]);
 
             int lo = y, hi = y;
-            if (do_fill) {
+            if (envelopes != NULL) {
+                lo = (dh - 1) - rows->high[k * rows->n + j];
+                hi = fill ? dh - 1 : (dh - 1) - rows->low[k * rows->n + j];
+            } else if (fill) {
                 hi = dh - 1;
-            } else if (prev_valid) {
+            } else if (joined || half == 1) {
                 lo = (prev_y < y) ? prev_y : y;
                 hi = (prev_y < y) ? y : prev_y;
             }
             for (int yy = lo; yy <= hi; yy++) {
-                int idx = (yy / sub) * pw + a;
-                canvas[idx] |= bits[(yy % sub) * 2 + (x & 1)];
-                owner[idx] = who;
+                canvas[yy / sub] |= bits[(yy % sub) * 2 + half];
+                if (owner[yy / sub] < who)
+                    owner[yy / sub] = who;
             }
             prev_y = y;
-            prev_valid = true;
         }
     }
 
     for (int r = 0; r < ph; r++) {
-        for (int c = 0; c < pw; c++) {
-            unsigned char b = canvas[r * pw + c];
-            if (! b)
+        const cchar_t *cell =
+            canvas[r] ? &dots_glyphs[(owner[r] - 1) * masks + canvas[r]] : &blank;
+        mvwadd_wch(dots_pad, 1 + r, col, cell);
+    }
+}
+
+// Rasterize the columns of records [first, end), mapping the values they need to
+// sub-pixel rows all at once.
+static void dots_columns(long long first, long long end, long long oldest, int ph,
+                         int pw, double max, double min, int sub,
+                         const unsigned char *bits) {
+    const struct row_map map = dot_map(ph * sub, max, min);
+    const int n = end - first + 1;
+    const struct dot_rows rows = {first - 1,
+                                  n,
+                                  scratch_rows,
+                                  scratch_rows + series * n,
+                                  scratch_rows + 2 * series * n,
+                                  scratch_rows + 3 * series * n};
+
+    if (first >= end)
+        return;
+    for (int k = 0; k < series; k++) {
+        series_rows(k, rows.base, n, ROWS_VALUE, &map, scratch_rows + k * n);
+        series_rows(k, rows.base, n, ROWS_MIDPOINT, &map,
+                    scratch_rows + (series + k) * n);
+        if (envelopes == NULL)
+            continue;
+        series_rows(k, rows.base, n, ROWS_LOW, &map,
+                    scratch_rows + (2 * series + k) * n);
+        series_rows(k, rows.base, n, ROWS_HIGH, &map,
+                    scratch_rows + (3 * series + k) * n);
+    }
+    for (long long i = first; i < end; i++)
+        dots_column(i, oldest, ph, pw, sub, bits, &rows);
+}
+
+// Render all series onto a sub-cell pixel grid (sub vertical pixels per cell, 2
+// horizontal), one time step at a time. Where lines cross, the later series wins.
+// glyphs==NULL selects braille (U+2800+bits); otherwise a 16-entry quadrant table.
+static void plot_dots(int ph, int pw, double max, double min, int sub,
+                      const unsigned char *bits, const wchar_t *glyphs) {
+    const int first_col = 3;
+    const int last = (v + pw - 1) % pw;  // column of the newest record
+    const long long oldest = v - pw;     // first record in view
+
+    if (ph <= 0 || pw <= 0 || ! make_dots_glyphs(sub, glyphs))
+        return;
+
+    if (dots_pad == NULL || ph != dots_ph || pw != dots_pw) {
+        if (dots_pad != NULL)
+            delwin(dots_pad);
+        free(dots_canvas);
+        free(dots_owner);
+        dots_pad = newpad(ph + 1, pw);  // row 0 unused, so pad rows match screen rows
+        dots_canvas = malloc((size_t)ph * pw);
+        dots_owner = malloc((size_t)ph * pw);
+        if (dots_pad == NULL || dots_canvas == NULL || dots_owner == NULL) {
+            if (dots_pad != NULL)
+                delwin(dots_pad);
+            dots_pad = NULL;
+            return;
+        }
+        dots_ph = ph;
+        dots_pw = pw;
+        dots_v = -pw;  // force a full redraw
+    }
+    if (! reserve_scratch(pw + 1, 4 * series * (pw + 1)))
+        return;
+
+    if (max != dots_max || min != dots_min || sub != dots_sub || v - dots_v >= pw) {
+        werase(dots_pad);
+        dots_columns((oldest < 0) ? 0 : oldest, v, oldest, ph, pw, max, min, sub, bits);
+    } else if (v > dots_v) {
+        // The previous newest record now has a successor, and the oldest one in view
+        // no longer has a predecessor.
+        const int first = (dots_v - 1 > oldest) ? dots_v - 1 : oldest;
+        dots_columns(first, v, oldest, ph, pw, max, min, sub, bits);
+        if (oldest >= 0 && oldest < dots_v - 1)
+            dots_columns(oldest, oldest + 1, oldest, ph, pw, max, min, sub, bits);
+    }
+    dots_max = max;
+    dots_min = min;
+    dots_sub = sub;
+    dots_v = v;
+
+    // Oldest slots first, then the ones up to and including the newest.
+    if (last + 1 < pw)
+        copywin(dots_pad, stdscr, 1, last + 1, 1, first_col, ph,
+                first_col + pw - last - 2, FALSE);
+    copywin(dots_pad, stdscr, 1, 0, 1, first_col + pw - last - 1, ph,
+            first_col + pw - 1, FALSE);
+}
+
+// Heatmap (-d): each cell shows how many samples of its column fell into its range of
+// values, relative to the most in any cell in view, as one of HEAT_LEVELS glyphs of
+// growing density and color: braille dots with -b, quadrants of block elements
+// otherwise, or ASCII characters without wide characters. The row of each bin is the
+// same in every column, so a frame maps the bins once, adds up the bins of the columns
+// in view and draws every cell: its cost does not depend on the input rate.
+#define HEAT_LEVELS 5
+static const unsigned char heat_braille[HEAT_LEVELS] = {0x02, 0x12, 0x1B, 0x3F, 0xFF};
+static const unsigned char heat_quads[HEAT_LEVELS] = {0x08, 0x09, 0x0E, 0x0F, 0x0F};
+static const char heat_ascii[HEAT_LEVELS] = {'.', ':', '+', '*', '#'};
+static const short heat_palette[HEAT_LEVELS] = {C_BLUE, C_CYAN, C_GREEN, C_YELLOW,
+                                                C_RED};  // pairs PAIR_BR1 + level
+
+static void plot_heat(int ph, int pw, double max, double min) {
+    const int first_col = 3;
+    cchar_t glyphs[HEAT_LEVELS];
+
+    if (ph <= 0 || pw <= 0 || heat_counts == NULL ||
+        ! reserve_scratch(HEAT_BINS, HEAT_BINS + ph * pw))
+        return;
+    for (int l = 0; l < HEAT_LEVELS; l++) {
+        wchar_t ws[2] = {braille           ? (wchar_t)(0x2800 + heat_braille[l])
+                         : (MB_CUR_MAX > 1) ? quad_glyphs[heat_quads[l]]
+                                            : (wchar_t)heat_ascii[l],
+                         0};
+        setcchar(&glyphs[l], ws, A_NORMAL, PAIR_BR1 + l, NULL);
+    }
+
+    // The row of each bin, counted from the bottom.
+    int *bin_rows = scratch_rows, *cells = scratch_rows + HEAT_BINS;
+    const double f_max = heat_f(max), f_min = heat_f(min);
+    const struct row_map map = dot_map(ph, f_max, f_min);
+    for (int b = 0; b < HEAT_BINS; b++)
+        scratch_values[b] = heat_origin + (b + 0.5) * heat_step;
+    value_rows(scratch_values, HEAT_BINS, &map, bin_rows);
+
+    // Column x shows record number v - pw + x.
+    unsigned most = 0;
+    memset(cells, 0, (size_t)ph * pw * sizeof(int));
+    for (int x = 0; x < pw; x++) {
+        const long long i = v - pw + x;
+        if (heat_step == 0 || get_record(i) == NULL)
+            continue;
+        const unsigned *bins = heat_counts + (i % capacity) * HEAT_BINS;
+        for (int b = 0; b < HEAT_BINS; b++) {
+            if (bins[b] == 0)
                 continue;
-            wchar_t ws[2] = {glyphs ? glyphs[b] : (wchar_t)(0x2800 + b), 0};
-            cchar_t cc;
-            short pair = (owner[r * pw + c] == 2) ? PAIR_BR2 : PAIR_BR1;
-            setcchar(&cc, ws, A_NORMAL, pair, NULL);
-            mvadd_wch(1 + r, first_col + c, &cc);
+            int *cell = &cells[x * ph + bin_rows[b]];
+            *cell += bins[b];
+            if ((unsigned)*cell > most)
+                most = *cell;
         }
     }
 
-    free(canvas);
-    free(owner);
+    for (int x = 0; x < pw; x++)
+        for (int r = 0; r < ph; r++) {
+            const unsigned count = cells[x * ph + r];
+            if (count == 0) {
+                mvaddch(ph - r, first_col + x, ' ');
+                continue;
+            }
+            const int level = ((unsigned long long)count * HEAT_LEVELS - 1) / most;
+            mvadd_wch(ph - r, first_col + x, &glyphs[level]);
+        }
 }
 
 #ifdef AALIB
+// Sub-pixel row of a value, 0 at the top.
+static int dot_row(double value, int dh, double max, double min) {
+    const struct row_map m = dot_map(dh, max, min);
+    return (dh - 1) - value_row(value, &m);
+}
+
 // aa is the "dumb terminal" tier: smooth lines in plain 7-bit ASCII. In a C/POSIX
 // locale aalib natively emits its 7-bit glyph ramp, which we pass through untouched.
 // In a UTF-8 locale it insists on 8-bit CP437 glyphs instead (a load-time decision we
@@ -629,79 +1843,121 @@ static char aa_ascii(unsigned char b) {
     return b ? '*' : ' ';
 }
 
-// Experimental: render up to two series as aalib 7-bit ASCII-art, one pass each so the
-// two lines can be colored independently (like braille/block mode: line 1 PAIR_BR1,
-// line 2 PAIR_BR2). Without -f each series is a connected line; with -f, line 1's area
-// is filled. The aalib context is recreated every paint so it tracks resizes for free.
-static void plot_aa(int ph, int pw, double *v1, double *v2, double max, double min,
-                    int n) {
-    const int first_col = 3;
-    if (ph <= 0 || pw <= 0)
-        return;
-
-    double range = max - min;
-    if (range <= 0)
-        range = 1;
-
-    struct aa_hardware_params hp = aa_defparams;
-    hp.width = pw;
-    hp.height = ph;
-    aa_context *c = aa_init(&mem_d, &hp, NULL);
-    if (! c)
-        return;
-
-    const int iw = aa_imgwidth(c), ih = aa_imgheight(c);
-
-    for (int pass = 0; pass < 2; pass++) {
-        double *vals = (pass == 0) ? v1 : v2;
-        int do_fill = (pass == 0) ? braille_fill : 0;  // -f fills line 1 only
-        short pair = (pass == 0) ? PAIR_BR1 : PAIR_BR2;
-        if (! vals)
+// Experimental: render the series as aalib 7-bit ASCII-art, one pass each so the
+// lines can be colored independently (like braille/block mode: line k in pair
+// PAIR_BR1 + k). Without -f each series is a connected line; with -f, line 1's area
+// is filled. Like in plot_dots(), the text of record i is kept in column i % pw of a
+// pad that is copied to the screen rotated. Rendering without dithering makes each
+// cell depend on its own pixels only, so a new record needs just its own column of
+// the image drawn and rendered, plus that of the oldest one in view, which loses its
+// joining segment. The aalib context is only recreated when the plot is resized.
+static aa_context *aa_ctx = NULL;
+static aa_renderparams aa_params;
+static WINDOW *aa_pad = NULL;
+static int aa_ph = -1, aa_pw = -1;  // state the pad was drawn for
+static long long aa_v = 0;
+static double aa_max, aa_min;
+
+// Draw and render the column of record i, for records from number `oldest` on in
+// view, into the pad.
+static void aa_column(long long i, long long oldest, int ph, int pw, double max,
+                      double min) {
+    const int iw = aa_imgwidth(aa_ctx), ih = aa_imgheight(aa_ctx);
+    const int col = i % pw, x0 = col * iw / pw, x1 = (col + 1) * iw / pw;
+    unsigned char *image = aa_image(aa_ctx);
+    const unsigned char *text = aa_text(aa_ctx);
+
+    mvwvline(aa_pad, 1, col, ' ', ph);
+    for (int k = 0; k < series; k++) {
+        const int do_fill = (k == 0) ? braille_fill : 0;  // -f fills line 1 only
+        const short pair = PAIR_BR1 + k;
+        const double va = get_value(k, i);
+        const double vp = (i > oldest) ? get_value(k, i - 1) : NAN;
+        if (isnan(va))
             continue;
 
-        memset(aa_image(c), 0, (size_t)iw * ih);
-
-        int prev_y = 0;
-        bool prev_valid = false;
-        for (int x = 0; x < iw; x++) {
-            int a = x * pw / iw;  // image column -> data column
-            double va = vals[(n + 1 + a) % pw];
-            if (isnan(va)) {
-                prev_valid = false;
-                continue;
-            }
-            double frac = (va - min) / range;
-            if (frac < 0)
-                frac = 0;
-            if (frac > 1)
-                frac = 1;
-            int y = (ih - 1) - (int)lrint(frac * (ih - 1));
-
+        for (int yy = 0; yy < ih; yy++)
+            memset(image + (size_t)yy * iw + x0, 0, x1 - x0);
+        const int y = dot_row(va, ih, max, min);
+        int prev_y = isnan(vp) ? y : dot_row(vp, ih, max, min);
+        for (int x = x0; x < x1; x++) {
             int lo = y, hi = y;
             if (do_fill) {
                 hi = ih - 1;
-            } else if (prev_valid) {
+            } else {
                 lo = (prev_y < y) ? prev_y : y;
                 hi = (prev_y < y) ? y : prev_y;
             }
             for (int yy = lo; yy <= hi; yy++)
-                aa_putpixel(c, x, yy, 255);
+                aa_putpixel(aa_ctx, x, yy, 255);
             prev_y = y;
-            prev_valid = true;
         }
 
-        aa_render(c, &aa_defrenderparams, 0, 0, pw, ph);
-        unsigned char *text = aa_text(c);
-        for (int r = 0; r < ph; r++)
-            for (int col = 0; col < pw; col++) {
-                unsigned char b = text[r * pw + col];
-                if (b == 0 || b == ' ')
-                    continue;
-                mvaddch(1 + r, first_col + col, (chtype)aa_ascii(b) | COLOR_PAIR(pair));
-            }
+        aa_render(aa_ctx, &aa_params, col, 0, col + 1, ph);
+        for (int r = 0; r < ph; r++) {
+            unsigned char b = text[r * pw + col];
+            if (b == 0 || b == ' ')
+                continue;
+            mvwaddch(aa_pad, 1 + r, col, (chtype)aa_ascii(b) | COLOR_PAIR(pair));
+        }
     }
+}
 
-    aa_close(c);
+static void plot_aa(int ph, int pw, double max, double min) {
+    const int first_col = 3;
+    const int last = (v + pw - 1) % pw;  // column of the newest record
+    const long long oldest = v - pw;     // first record in view
+    long long i;
+
+    if (ph <= 0 || pw <= 0)
+        return;
+
+    if (aa_ctx == NULL || ph != aa_ph || pw != aa_pw) {
+        struct aa_hardware_params hp = aa_defparams;
+        hp.width = pw;
+        hp.height = ph;
+        if (aa_ctx != NULL)
+            aa_close(aa_ctx);
+        if (aa_pad != NULL)
+            delwin(aa_pad);
+        aa_ctx = aa_init(&mem_d, &hp, NULL);
+        aa_pad = newpad(ph + 1, pw);  // row 0 unused, so pad rows match screen rows
+        if (aa_ctx == NULL || aa_pad == NULL) {
+            if (aa_ctx != NULL)
+                aa_close(aa_ctx);
+            if (aa_pad != NULL)
+                delwin(aa_pad);
+            aa_ctx = NULL;
+            aa_pad = NULL;
+            return;
+        }
+        aa_params = aa_defrenderparams;
+        aa_params.dither = AA_NONE;
+        aa_ph = ph;
+        aa_pw = pw;
+        aa_v = -pw;  // force a full redraw
+    }
+
+    if (max != aa_max || min != aa_min || v - aa_v >= pw) {
+        werase(aa_pad);
+        for (i = (oldest < 0) ? 0 : oldest; i < v; i++)
+            aa_column(i, oldest, ph, pw, max, min);
+    } else if (v > aa_v) {
+        for (i = (aa_v > oldest) ? aa_v : oldest; i < v; i++)
+            aa_column(i, oldest, ph, pw, max, min);
+        if (oldest >= 0 && oldest < aa_v)
+            aa_column(oldest, oldest, ph, pw, max, min);
+    }
+    aa_max = max;
+    aa_min = min;
+    aa_v = v;
+
+    // Oldest slots first, then the ones up to and including the newest.
+    if (last + 1 < pw)
+        copywin(aa_pad, stdscr, 1, last + 1, 1, first_col, ph,
+                first_col + pw - last - 2, FALSE);
+    copywin(aa_pad, stdscr, 1, 0, 1, first_col + pw - last - 1, ph,
+            first_col + pw - 1, FALSE);
 }
 #endif
 
@@ -721,46 +1977,156 @@ static void show_all_centered(const char *message) {
 }
 
 static int window_big_enough_to_draw(void) {
-    return (width >= WIDTH_MIN) && (height >= HEIGHT_MIN);
+    const int extra_status_rows = (series > 2) ? series - 2 : 0;
+    return (width >= WIDTH_MIN) && (height >= HEIGHT_MIN + extra_status_rows);
 }
 
 static void show_window_size_error(void) {
     show_all_centered("Window too small...");
 }
 
+// A status line, built field by field to fit in `room` columns, so that it never
+// wraps onto the next row: the first field is cut short if need be, and the fields
+// after the first one that does not fit whole are left out.
+struct status_line {
+    char text[512];
+    int length, room;
+    bool full;
+};
+
+static void status_field(struct status_line *s, const char *format, ...) {
+    char field[sizeof(s->text)];
+    va_list ap;
+    va_start(ap, format);
+    int n = vsnprintf(field, sizeof(field), format, ap);
+    va_end(ap);
+    if (s->full || n < 0)
+        return;
+    if (s->length + n > s->room) {
+        s->full = true;
+        if (s->length > 0)
+            return;
+        n = s->room;
+    }
+    memcpy(s->text + s->length, field, n);
+    s->length += n;
+    s->text[s->length] = '\0';
+}
+
+// Add the percentiles of series k to its status line, given the extremes of its
+// window, which the session ones replace with their own.
+static void status_percentiles(struct status_line *s, int k, double min, double max) {
+    const struct quantiles *q = &stats[k].quantiles;
+    if (percentiles == PERCENTILES_SESSION) {
+        q = &session_quantiles[k];
+        min = session_mins[k];
+        max = session_maxes[k];
+    }
+    status_field(s, " p50=%.1f p95=%.1f p99=%.1f", quantiles_get(q, 0.50, min, max),
+                 quantiles_get(q, 0.95, min, max), quantiles_get(q, 0.99, min, max));
+}
+
 static void paint_plot(void) {
-    double min, max;
-    double min1 = FLT_MAX, max1 = -FLT_MAX, avg1 = 0;
-    double min2 = FLT_MAX, max2 = -FLT_MAX, avg2 = 0;
+    double min = FLT_MAX, max = -FLT_MAX;
+    double mins[MAX_SERIES], maxes[MAX_SERIES], avgs[MAX_SERIES];
     struct tm *lt;
-    erase();
+    static int painted_height = -1, painted_width = -1;
+    const int status_rows = (series > 2) ? series : 2;  // one per series, at the bottom
+
     getmaxyx(stdscr, height, width);
 
-    plotheight = height - HEIGHT_MARGIN;
+    // The plot area is fully overwritten from one of the pads, so the screen only
+    // needs erasing after a resize; the status lines are cleared separately.
+    if (height != painted_height || width != painted_width) {
+        erase();
+        painted_height = height;
+        painted_width = width;
+    } else {
+        move(height - status_rows, 0);
+        clrtobot();
+    }
+
+    plotheight = height - HEIGHT_MARGIN - (status_rows - 2);
     plotwidth = width - WIDTH_MARGIN;
-    if (plotwidth >= (int)((sizeof(values1) / sizeof(double)) - 1))
-        exit(0);
+    if (capacity != ((history > plotwidth) ? history : plotwidth))
+        resize_values((history > plotwidth) ? history : plotwidth);
+    if (stats[0].size != plotwidth) {
+        for (int k = 0; k < series; k++)
+            window_stats_rebuild(&stats[k], k, plotwidth);
+    }
 
-    getminmax(plotwidth, values1, &min1, &max1, &avg1, v);
-    getminmax(plotwidth, values2, &min2, &max2, &avg2, v);
+    for (int k = 0; k < series; k++) {
+        window_stats_get(&stats[k], &mins[k], &maxes[k], &avgs[k]);
+        if (heatmap != HEAT_NONE && k > 0)  // only the first series is drawn
+            continue;
+        if (maxes[k] > max)
+            max = maxes[k];
+        if (mins[k] < min)
+            min = mins[k];
+    }
 
-    max = max1 > max2 ? max1 : max2;
     if (max < softmax)
         max = softmax;
     if (hardmax != FLT_MAX)
         max = hardmax;
 
-    min = min1 < min2 ? min1 : min2;
     if (min > softmin)
         min = softmin;
     if (hardmin != -FLT_MAX)
         min = hardmin;
 
+    // A logarithmic scale starts at the smallest positive sample in view, if any.
+    if (heatmap == HEAT_LOG && min <= 0)
+        min = (mins[0] > 0 && mins[0] < FLT_MAX) ? mins[0] : 1;
+    if (heatmap == HEAT_LOG && max < 2 * min)
+        max = 2 * min;
+
     // Apply text color if specified
     if (colors[TEXT_COLOR] != -1)
         attron(COLOR_PAIR(TEXT_COLOR + 1));
 
-    mvaddstr(height - 1, width - strlen(verstring) - 1, verstring);
+    // Where the status lines sharing the rows of the clock and the version end.
+    int row_ends[2] = {0, 0};
+    for (int k = 0; k < series; k++) {
+        const int row = height - status_rows + k;
+        if (braille || block) {
+            wchar_t iw[2] = {braille ? 0x28FF : 0x2588, 0};
+            cchar_t ind;
+            setcchar(&ind, iw, A_NORMAL, PAIR_BR1 + k, NULL);
+            mvadd_wch(row, 5, &ind);
+        } else if (aa) {
+            mvaddch(row, 5, '#' | COLOR_PAIR(PAIR_BR1 + k));
+        } else if (k == 0) {
+            mvvline_set(row, 5, &plotchar, 1);
+        } else if (k == 1) {
+            mvaddch(row, 5, ' ' | A_REVERSE);
+        } else {
+            mvaddch(row, 5, series_marks[k - 2] | A_BOLD);
+        }
+        // From column 7 up to, but not including, the last one.
+        struct status_line status = {.length = 0, .room = width - 8, .full = false};
+        if (status.room >= (int)sizeof(status.text))
+            status.room = sizeof(status.text) - 1;
+        status.text[0] = '\0';
+        if (v > 0) {
+            status_field(&status, "last=%.1f min=%.1f max=%.1f avg=%.1f%s%s",
+                         get_value(k, v - 1), mins[k], maxes[k], avgs[k],
+                         (unit[0] != '\0') ? " " : "", unit);
+            if (percentiles != PERCENTILES_NONE)
+                status_percentiles(&status, k, mins[k], maxes[k]);
+            if (rate && k == 0)
+                status_field(&status, " interval=%.3gs", td);
+            if (show_frame_records && k == 0)
+                status_field(&status, " records/frame=%d", frame_records);
+            mvaddstr(row, 7, status.text);
+        }
+        if (row >= height - 2) {
+            int end = 7 + status.length;  // blanks aside, as the clock may go there
+            while (end > 7 && status.text[end - 8] == ' ')
+                end--;
+            row_ends[row - (height - 2)] = end;
+        }
+    }
 
     if (width >= WIDTH_CLOCK_MIN) {
         const char *clock_display;
@@ -772,229 +2138,1307 @@ static void paint_plot(void) {
             ls[strlen(ls) - 1] = '\0';  // drop trailing newline, see asctime_r(3)
             clock_display = ls;
         }
-        mvaddstr(height - 2, width - strlen(clock_display) - 1, clock_display);
+        // Unless the status line runs into it, as for the version below.
+        if (row_ends[0] < width - (int)strlen(clock_display) - 1)
+            mvaddstr(height - 2, width - strlen(clock_display) - 1, clock_display);
     }
+    if (row_ends[1] < width - (int)strlen(verstring) - 1)
+        mvaddstr(height - 1, width - strlen(verstring) - 1, verstring);
 
     if (colors[TEXT_COLOR] != -1)
         attroff(COLOR_PAIR(TEXT_COLOR + 1));
 
-    // Apply text color for stats
-    if (colors[TEXT_COLOR] != -1)
-        attron(COLOR_PAIR(TEXT_COLOR + 1));
+    if (heatmap != HEAT_NONE)
+        plot_heat(plotheight, plotwidth, max, min);
+    else if (braille)
+        plot_dots(plotheight, plotwidth, max, min, 4, braille_bits, NULL);
+    else if (block)
+        plot_dots(plotheight, plotwidth, max, min, 2, quad_bits, quad_glyphs);
+#ifdef AALIB
+    else if (aa)
+        plot_aa(plotheight, plotwidth, max, min);
+#endif
+    else
+        plot_values(plotheight, plotwidth, max, min, &plotchar, &max_errchar,
+                    &min_errchar, hardmax, hardmin);
+
+    draw_axes(height - (status_rows - 2), plotheight, plotwidth, max, min, unit);
+
+    // Apply title color if specified
+    if (colors[TITLE_COLOR] != -1)
+        attron(COLOR_PAIR(TITLE_COLOR + 1));
+
+    mvaddstr(0, (width / 2) - (strlen(title) / 2), title);
+
+    if (colors[TITLE_COLOR] != -1)
+        attroff(COLOR_PAIR(TITLE_COLOR + 1));
+
+    move(0, 0);
+}
+
+// Send signals through a pipe, in order to catch them without race conditions.
+// pselect() could be an alternative, but it is unreliable on Linux.
+// (Related: https://stackoverflow.com/q/62315082)
+static void signal_handler(int signum) {
+    const unsigned char signal_number =
+        (unsigned char)signum;  // signum is either 2 (SIGINT) or 28 (SIGWINCH)
+    ssize_t write_res;
+    int saved_errno = errno;
+    do {
+        write_res = write(signal_write_fd, &signal_number, 1);
+    } while ((write_res == -1) && (errno == EINTR));
+    errno = saved_errno;
+}
+
+// Return a monotonic timestamp in seconds, for timing frames and scheduling them.
+static double monotonic_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
 
-    if (braille || block) {
-        wchar_t iw[2] = {braille ? 0x28FF : 0x2588, 0};
-        cchar_t ind;
-        setcchar(&ind, iw, A_NORMAL, PAIR_BR1, NULL);
-        mvadd_wch(height - 2, 5, &ind);
-    } else if (aa) {
-        mvaddch(height - 2, 5, '#' | COLOR_PAIR(PAIR_BR1));
+// Diagnostics overlay (-D, hotkey d), to tell whether ttyplot keeps up with its input
+// and with its terminal. The counters are always kept: they cost an atomic addition
+// per chunk of input, and two clock readings and on Linux two reads of
+// /proc/thread-self/io per frame.
+#define DIAGNOSTICS_PERIOD 1.0  // seconds over which rates and averages are taken
+
+static bool show_diagnostics = false;
+
+// Counted by the input thread, read by the main thread.
+static size_t input_bytes = 0;      // bytes read from the input
+static size_t rejected_tokens = 0;  // garbage tokens, and samples that are not finite
+static size_t dropped_bytes = 0;    // discarded with tokens too long for the buffer
+
+static struct {
+    double start;                       // when the current period started
+    size_t bytes;                       // input_bytes then
+    long long records;                  // input_records then
+    int frames;                         // painted since
+    double paint, refresh, worst;       // their total paint and refresh() times
+    double bytes_rate, records_rate;    // over the last full period
+    double frames_rate, paint_average;  // ditto
+    double refresh_average, refresh_worst;  // worst: the longest refresh()
+    long long output;                   // output_bytes then
+    double output_average;              // bytes sent to the terminal per frame
+} diagnostics;
+
+// Bytes sent to the terminal. ncurses writes to the file descriptor directly, so on
+// Linux they are taken from the I/O accounting of the main thread, which is the only
+// one writing while the screen is refreshed; elsewhere they are not counted.
+static long long output_bytes = 0;
+static int output_io_fd = -1;  // /proc/thread-self/io
+
+static void setup_output_counter(void) {
+#ifdef __linux__
+    output_io_fd = open("/proc/thread-self/io", O_RDONLY | O_CLOEXEC);
+#endif
+}
+
+// Bytes written by the main thread so far, or -1 if they are not counted.
+static long long written_bytes(void) {
+    char buffer[256];
+    long long wchar;
+    if (output_io_fd == -1)
+        return -1;
+    const ssize_t n = pread(output_io_fd, buffer, sizeof(buffer) - 1, 0);
+    if (n <= 0)
+        return -1;
+    buffer[n] = '\0';
+    const char *line = strstr(buffer, "wchar:");
+    return (line && sscanf(line, "wchar: %lld", &wchar) == 1) ? wchar : -1;
+}
+
+// Synchronized output (DEC private mode 2026), where the terminfo entry has the Sync
+// capability: the terminal holds back the frame until it is complete, so it does not
+// tear when it arrives in pieces, as it does through SSH and tmux.
+static char *sync_begin = NULL, *sync_end = NULL;
+
+static void setup_sync(void) {
+    char *sync = tigetstr("Sync");
+    if (sync == NULL || sync == (char *)-1)
+        return;
+    sync_begin = strdup(tparm(sync, 1));
+    sync_end = strdup(tparm(sync, 2));
+}
+
+// Send the changes of the frame to the terminal. refresh() flushes its output, so
+// that the sequences written around it bracket the whole frame.
+static void refresh_terminal(void) {
+    const long long before = written_bytes();
+    if (sync_begin != NULL && write(STDOUT_FILENO, sync_begin, strlen(sync_begin)) < 0)
+        sync_begin = NULL;
+    refresh();
+    if (sync_end != NULL && write(STDOUT_FILENO, sync_end, strlen(sync_end)) < 0)
+        sync_end = NULL;
+    const long long after = written_bytes();
+    if (before >= 0 && after >= before)
+        output_bytes += after - before;
+}
+
+static void diagnostics_count(size_t *counter, size_t n) {
+    if (n > 0)
+        __atomic_fetch_add(counter, n, __ATOMIC_RELAXED);
+}
+
+// Account for a frame, and take the figures of the period once it is over.
+static void diagnostics_frame(double paint_time, double refresh_time) {
+    const double t = monotonic_now();
+    const size_t bytes = __atomic_load_n(&input_bytes, __ATOMIC_RELAXED);
+    if (diagnostics.start == 0) {
+        diagnostics.start = t;
+        diagnostics.bytes = bytes;
+        diagnostics.records = input_records;
+        diagnostics.output = output_bytes;
+    }
+    diagnostics.frames++;
+    diagnostics.paint += paint_time;
+    diagnostics.refresh += refresh_time;
+    if (refresh_time > diagnostics.worst)
+        diagnostics.worst = refresh_time;
+
+    const double elapsed = t - diagnostics.start;
+    if (elapsed < DIAGNOSTICS_PERIOD)
+        return;
+    diagnostics.bytes_rate = (bytes - diagnostics.bytes) / elapsed;
+    diagnostics.records_rate = (input_records - diagnostics.records) / elapsed;
+    diagnostics.frames_rate = diagnostics.frames / elapsed;
+    diagnostics.paint_average = diagnostics.paint / diagnostics.frames;
+    diagnostics.refresh_average = diagnostics.refresh / diagnostics.frames;
+    diagnostics.refresh_worst = diagnostics.worst;
+    diagnostics.output_average =
+        (double)(output_bytes - diagnostics.output) / diagnostics.frames;
+    diagnostics.start = t;
+    diagnostics.bytes = bytes;
+    diagnostics.records = input_records;
+    diagnostics.output = output_bytes;
+    diagnostics.frames = 0;
+    diagnostics.paint = diagnostics.refresh = diagnostics.worst = 0;
+}
+
+// Print a number of bytes with a binary prefix.
+static void format_bytes(char *s, size_t size, double bytes) {
+    const char *prefixes[] = {"", "Ki", "Mi", "Gi", "Ti"};
+    int i = 0;
+    while (bytes >= 1024 && i < 4) {
+        bytes /= 1024;
+        i++;
+    }
+    snprintf(s, size, (i == 0) ? "%.0f %sB" : "%.1f %sB", bytes, prefixes[i]);
+}
+
+// Draw the overlay in the top left corner of the plot, where the next frame paints
+// over it.
+static void draw_diagnostics(void) {
+    char lines[5][64], rate[16], dropped[16], output[16];
+    format_bytes(rate, sizeof(rate), diagnostics.bytes_rate);
+    format_bytes(dropped, sizeof(dropped),
+                 __atomic_load_n(&dropped_bytes, __ATOMIC_RELAXED));
+    snprintf(lines[0], sizeof(lines[0]), " input %s/s, %.0f records/s ", rate,
+             diagnostics.records_rate);
+    snprintf(lines[1], sizeof(lines[1]), " garbage %zu tokens, dropped %s ",
+             __atomic_load_n(&rejected_tokens, __ATOMIC_RELAXED), dropped);
+    snprintf(lines[2], sizeof(lines[2]), " %.1f frames/s, paint %.2f ms ",
+             diagnostics.frames_rate, diagnostics.paint_average * 1e3);
+    snprintf(lines[3], sizeof(lines[3]), " refresh %.2f ms, worst %.2f ms ",
+             diagnostics.refresh_average * 1e3, diagnostics.refresh_worst * 1e3);
+    format_bytes(output, sizeof(output), diagnostics.output_average);
+    snprintf(lines[4], sizeof(lines[4]), " output %s/frame%s ",
+             (output_io_fd != -1) ? output : "?", sync_begin ? ", synchronized" : "");
+
+    attron(A_STANDOUT);  // reverse video, but told apart from the plot in snapshots
+    for (int i = 0; i < 5 && i + 2 <= plotheight; i++)
+        mvaddnstr(i + 2, 4, lines[i], plotwidth - 2);
+    attroff(A_STANDOUT);
+}
+
+// Paint a frame on the screen, without sending it to the terminal yet.
+static void draw_screen(const char *errstr) {
+    if (window_big_enough_to_draw()) {
+        paint_plot();
+        if (show_diagnostics)
+            draw_diagnostics();
+
+        if (errstr != NULL) {
+            show_all_centered(errstr);
+        } else if (v < 1) {
+            show_all_centered(follow_path ? "waiting for data from file"
+                                          : "waiting for data from stdin");
+        }
     } else {
-        mvvline_set(height - 2, 5, &plotchar, 1);
+        show_window_size_error();
     }
-    if (v > 0) {
-        mvprintw(height - 2, 7, "last=%.1f min=%.1f max=%.1f avg=%.1f %s ", values1[n],
-                 min1, max1, avg1, unit);
-        if (rate)
-            printw(" interval=%.3gs", td);
+}
+
+static void redraw_screen(const char *errstr) {
+    const double start = monotonic_now();
+    draw_screen(errstr);
+    const double painted = monotonic_now();
+    refresh_terminal();
+    diagnostics_frame(painted - start, monotonic_now() - painted);
+}
+
+// Headless mode (-o): there is no terminal. Frames are painted the usual way on a
+// screen that is never refreshed, and written out as text at snapshot time only, so
+// that ingesting costs the same as with a terminal, minus the painting.
+static const char *snapshot_path = NULL;  // -o: file, or "-" for stdout
+static double snapshot_interval = 0;      // -w: seconds between snapshots, 0 = at exit
+
+// The screen is sized by $COLUMNS and $LINES, 80x24 by default.
+static void setup_headless(void) {
+    FILE *out = fopen("/dev/null", "w"), *in = fopen("/dev/null", "r");
+    if (out == NULL || in == NULL || newterm("dumb", out, in) == NULL) {
+        fprintf(stderr, "Error: failed to initialize ncurses\n");
+        exit(1);
     }
-    if (two) {
-        if (braille || block) {
-            wchar_t iw[2] = {braille ? 0x28FF : 0x2588, 0};
-            cchar_t ind;
-            setcchar(&ind, iw, A_NORMAL, PAIR_BR2, NULL);
-            mvadd_wch(height - 1, 5, &ind);
-        } else if (aa) {
-            mvaddch(height - 1, 5, '#' | COLOR_PAIR(PAIR_BR2));
-        } else {
-            mvaddch(height - 1, 5, ' ' | A_REVERSE);
+    const char *columns = getenv("COLUMNS"), *lines = getenv("LINES");
+    const int w = columns ? atoi(columns) : 0, h = lines ? atoi(lines) : 0;
+    resize_term((h > 0) ? h : 24, (w > 0) ? w : 80);
+}
+
+// The characters drawn for the line drawing characters of the axes (T_HLINE etc.).
+static wchar_t snapshot_acs(wchar_t c) {
+    const bool utf8 = MB_CUR_MAX > 1;
+    switch (c) {
+        case L'q':
+            return utf8 ? 0x2500 : L'-';
+        case L'x':
+            return utf8 ? 0x2502 : L'|';
+        case L'm':
+            return utf8 ? 0x2514 : L'L';
+        default:
+            return c;
+    }
+}
+
+// Write one row of the screen as text, without trailing blanks, using line as a
+// buffer of width * MB_LEN_MAX bytes. Reverse video cells, the second line of the
+// default mode, become full blocks, except for error characters.
+static void write_snapshot_row(FILE *f, int y, char *line) {
+    const wchar_t block = (MB_CUR_MAX > 1) ? 0x2588 : L'#';
+    size_t length = 0, kept = 0;
+    mbstate_t state;
+    memset(&state, 0, sizeof(state));
+    for (int x = 0; x < width; x++) {
+        cchar_t cell;
+        wchar_t wch[CCHARW_MAX + 1];
+        attr_t attrs = A_NORMAL;
+        short pair;
+        if (mvin_wch(y, x, &cell) == ERR ||
+            getcchar(&cell, wch, &attrs, &pair, NULL) == ERR)
+            wch[0] = L' ';
+        if (attrs & A_REVERSE) {
+            if (wch[0] != max_errchar.chars[0] && wch[0] != min_errchar.chars[0])
+                wch[0] = block;
+        } else if (attrs & A_ALTCHARSET) {
+            wch[0] = snapshot_acs(wch[0]);
         }
-        if (v > 0) {
-            mvprintw(height - 1, 7, "last=%.1f min=%.1f max=%.1f avg=%.1f %s   ",
-                     values2[n], min2, max2, avg2, unit);
+        size_t n = wcrtomb(line + length, wch[0], &state);
+        if (n == (size_t)-1) {
+            line[length] = '?';
+            n = 1;
+            memset(&state, 0, sizeof(state));
         }
+        length += n;
+        if (wch[0] != L' ')
+            kept = length;
+    }
+    fwrite(line, 1, kept, f);
+    fputc('\n', f);
+}
+
+// Write a snapshot of the plot. A file is replaced as a whole, so that its readers
+// never see half a frame; stdout gets one frame after another, each followed by an
+// empty line.
+static void write_snapshot(void) {
+    char temporary[4096];
+    const bool to_stdout = strcmp(snapshot_path, "-") == 0;
+    FILE *f = stdout;
+    if (! to_stdout) {
+        snprintf(temporary, sizeof(temporary), "%s.tmp", snapshot_path);
+        f = fopen(temporary, "w");
+        if (f == NULL) {
+            fprintf(stderr, "Error: cannot write %s: %s\n", temporary, strerror(errno));
+            return;
+        }
+    }
+
+    getmaxyx(stdscr, height, width);
+    draw_screen(NULL);
+    char *line = malloc((size_t)width * MB_LEN_MAX);
+    for (int y = 0; line != NULL && y < height; y++)
+        write_snapshot_row(f, y, line);
+    free(line);
+
+    if (to_stdout) {
+        fputc('\n', f);
+        fflush(f);
+    } else if (fclose(f) != 0 || rename(temporary, snapshot_path) != 0) {
+        fprintf(stderr, "Error: cannot write %s: %s\n", snapshot_path, strerror(errno));
+    }
+}
+
+// Input delimiters are white space: ' ', '\t', '\r' and '\n'.
+static bool is_delimiter(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+// Bit k of a delimiter mask is set if p[k] is a delimiter.
+static uint64_t delimiter_mask_scalar(const char *p) {
+    uint64_t mask = 0;
+    for (int k = 0; k < 64; k++)
+        mask |= (uint64_t)is_delimiter(p[k]) << k;
+    return mask;
+}
+
+#ifdef X86_SIMD
+static uint64_t delimiter_mask_sse2(const char *p) {
+    uint64_t mask = 0;
+    for (int k = 0; k < 64; k += 16) {
+        const __m128i x = _mm_loadu_si128((const __m128i *)(p + k));
+        const __m128i d = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8(' ')),
+                         _mm_cmpeq_epi8(x, _mm_set1_epi8('\t'))),
+            _mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8('\r')),
+                         _mm_cmpeq_epi8(x, _mm_set1_epi8('\n'))));
+        mask |= (uint64_t)(unsigned)_mm_movemask_epi8(d) << k;
+    }
+    return mask;
+}
+
+__attribute__((target("avx2"))) static uint64_t delimiter_mask_avx2(const char *p) {
+    uint64_t mask = 0;
+    for (int k = 0; k < 64; k += 32) {
+        const __m256i x = _mm256_loadu_si256((const __m256i *)(p + k));
+        const __m256i d = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(x, _mm256_set1_epi8(' ')),
+                            _mm256_cmpeq_epi8(x, _mm256_set1_epi8('\t'))),
+            _mm256_or_si256(_mm256_cmpeq_epi8(x, _mm256_set1_epi8('\r')),
+                            _mm256_cmpeq_epi8(x, _mm256_set1_epi8('\n'))));
+        mask |= (uint64_t)(uint32_t)_mm256_movemask_epi8(d) << k;
+    }
+    return mask;
+}
+#endif
+
+static uint64_t delimiter_mask_resolve(const char *p);
+
+// Mask of the 64 bytes at p, using the best implementation this CPU supports.
+static uint64_t (*delimiter_mask)(const char *p) = delimiter_mask_resolve;
+
+static uint64_t delimiter_mask_resolve(const char *p) {
+    delimiter_mask = delimiter_mask_scalar;
+#ifdef X86_SIMD
+    delimiter_mask = delimiter_mask_sse2;
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        delimiter_mask = delimiter_mask_avx2;
+#endif
+    return delimiter_mask(p);
+}
+
+// Iterates over the tokens of a buffer, one 64-byte block of delimiter mask at a
+// time. The data must end with a delimiter.
+struct token_scanner {
+    char *block;    // start of the current block
+    char *end;      // end of the data
+    uint64_t mask;  // delimiter mask of the current block
+    int bit;        // position within the current block
+};
+
+static void token_scanner_load(struct token_scanner *s) {
+    if (s->end - s->block >= 64) {
+        s->mask = delimiter_mask(s->block);
+    } else {  // partial last block: bytes past the end count as delimiters
+        const int n = s->end - s->block;
+        s->mask = ~(uint64_t)0 << n;
+        for (int k = 0; k < n; k++)
+            s->mask |= (uint64_t)is_delimiter(s->block[k]) << k;
+    }
+    s->bit = 0;
+}
+
+static void token_scanner_init(struct token_scanner *s, char *buffer, size_t length) {
+    s->block = buffer;
+    s->end = buffer + length;
+    token_scanner_load(s);
+}
+
+// Find the next token. Return false if there are none left.
+static bool token_scanner_next(struct token_scanner *s, char **token, size_t *length) {
+    uint64_t bits;
+    while ((bits = ~s->mask & (~(uint64_t)0 << s->bit)) == 0) {
+        s->block += 64;
+        if (s->block >= s->end)
+            return false;
+        token_scanner_load(s);
+    }
+    s->bit = count_trailing_zeros(bits);
+    *token = s->block + s->bit;
+    while ((bits = s->mask & (~(uint64_t)0 << s->bit)) == 0) {
+        s->block += 64;  // cannot run past the end: the data ends with a delimiter
+        token_scanner_load(s);
+    }
+    s->bit = count_trailing_zeros(bits);
+    *length = s->block + s->bit - *token;
+    return true;
+}
+
+// Powers of ten that are exactly representable as doubles.
+static const double exact_powers_of_ten[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+// Parse a plain decimal number if the result is certain to be correctly rounded:
+// a mantissa of at most 2^53 scaled by an exact power of ten is a single rounding
+// (Clinger's fast path). Return false if unsure.
+static bool parse_decimal_fast(const char *s, const char *end, double *value) {
+#if FLT_EVAL_METHOD == 0 || FLT_EVAL_METHOD == 1
+    const bool negative = (*s == '-');
+    if (*s == '-' || *s == '+')
+        s++;
+    uint64_t mantissa = 0;
+    int digits = 0, significant = 0, exponent = 0;
+    for (; s < end && *s >= '0' && *s <= '9'; s++, digits++) {
+        if (mantissa != 0 || *s != '0')
+            significant++;
+        mantissa = mantissa * 10 + (*s - '0');
+    }
+    if (s < end && *s == '.') {
+        for (s++; s < end && *s >= '0' && *s <= '9'; s++, digits++, exponent--) {
+            if (mantissa != 0 || *s != '0')
+                significant++;
+            mantissa = mantissa * 10 + (*s - '0');
+        }
+    }
+    if (digits == 0 || significant > 19)
+        return false;
+    if (s < end && (*s == 'e' || *s == 'E')) {
+        s++;
+        const bool negative_exponent = (s < end && *s == '-');
+        if (s < end && (*s == '-' || *s == '+'))
+            s++;
+        if (s == end)
+            return false;
+        int e = 0;
+        for (; s < end && *s >= '0' && *s <= '9'; s++)
+            if (e < 10000)
+                e = e * 10 + (*s - '0');
+        exponent += negative_exponent ? -e : e;
+    }
+    if (s != end)
+        return false;
+    double result;
+    if (mantissa == 0)
+        result = 0;
+    else if (mantissa > (uint64_t)1 << 53 || exponent < -22 || exponent > 22)
+        return false;
+    else if (exponent >= 0)
+        result = (double)mantissa * exact_powers_of_ten[exponent];
+    else
+        result = (double)mantissa / exact_powers_of_ten[-exponent];
+    *value = negative ? -result : result;
+    return true;
+#else  // excess precision would round twice
+    (void)s;
+    (void)end;
+    (void)value;
+    return false;
+#endif
+}
+
+// Parse a token, which is followed by a delimiter, the way strtod() does.
+// Return whether it is a finite number with no trailing garbage.
+static bool parse_number(char *token, size_t length, double *value) {
+    static int decimal_point_is_dot = -1;  // strtod() follows LC_NUMERIC
+    if (decimal_point_is_dot < 0)
+        decimal_point_is_dot = (strcmp(localeconv()->decimal_point, ".") == 0);
+    if (decimal_point_is_dot && parse_decimal_fast(token, token + length, value))
+        return true;
+
+    const char saved = token[length];
+    char *number_end;
+    token[length] = '\0';
+    *value = strtod(token, &number_end);
+    token[length] = saved;
+    return number_end == token + length && isfinite(*value);
+}
+
+// Records travel from the input thread, which reads and parses the input, to the main
+// thread, which stores and plots them, through a single-producer single-consumer ring.
+// Each side only writes its own index, so no lock is taken, and neither side waits for
+// the other unless the ring is empty or full: a slow terminal holds up painting, but
+// no longer the reading of the input.
+#define INGEST_QUEUE_BYTES (4 * 1024 * 1024)
+
+// A file descriptor that polls readable once signaled, until cleared.
+struct wakeup {
+    int read_fd, write_fd;  // the same eventfd on Linux, the ends of a pipe elsewhere
+};
+
+static struct {
+    struct timeval *times;  // when each record was read, by the wall clock
+    double *clocks;         // when each record came, see handle_value()
+    double *values;         // `series` values per slot
+    size_t mask;            // number of slots - 1, a power of two
+    size_t head, tail;      // records pushed and popped, shared
+    size_t pushed;          // producer side: records pushed, published or not
+    size_t known_tail;      // producer side: the tail when last read
+    bool notified;          // the consumer was woken up and has not drained yet
+    bool waiting;           // the producer waits for room
+    bool closed;            // the input ended: nothing more will be pushed
+    char *error;            // why, set before closed
+    struct wakeup ready;    // records were pushed, or the input ended
+    struct wakeup room;     // records were popped while the producer was waiting
+} ingest;
+
+// The data being parsed, and when it was read: by the wall clock, and by the
+// monotonic clock along with the read before.
+static const char *chunk_start = NULL;
+static size_t chunk_length = 0;
+static struct timeval ingest_time;
+static double ingest_clock = 0, previous_ingest_clock = 0;
+static bool timestamps = false;  // -R: records start with their time in seconds
+
+static bool wakeup_init(struct wakeup *w) {
+#ifdef __linux__
+    w->read_fd = w->write_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (w->read_fd != -1)
+        return true;
+#endif
+    int fds[2];
+    if (pipe(fds) != 0)
+        return false;
+    fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+    fcntl(fds[1], F_SETFL, fcntl(fds[1], F_GETFL) | O_NONBLOCK);
+    w->read_fd = fds[0];
+    w->write_fd = fds[1];
+    return true;
+}
+
+static void wakeup_signal(const struct wakeup *w) {
+    const uint64_t one = 1;  // an eventfd takes 8 bytes, a pipe any
+    if (write(w->write_fd, &one, sizeof(one)) < 0)
+        return;  // full: already signaled
+}
+
+static void wakeup_clear(const struct wakeup *w) {
+    uint64_t buffer[64];
+    while (read(w->read_fd, buffer, sizeof(buffer)) > 0)
+        continue;
+}
+
+static void ingest_setup(void) {
+    const size_t record_size = sizeof(struct timeval) + (1 + series) * sizeof(double);
+    size_t slots = 1;
+    while (slots * 2 * record_size <= INGEST_QUEUE_BYTES)
+        slots *= 2;
+    ingest.times = calloc(slots, sizeof(struct timeval));
+    ingest.clocks = calloc(slots, sizeof(double));
+    ingest.values = calloc(slots * series, sizeof(double));
+    ingest.mask = slots - 1;
+    ingest_clock = monotonic_now();  // the first read spreads its records from here
+    if (ingest.times == NULL || ingest.clocks == NULL || ingest.values == NULL ||
+        ! wakeup_init(&ingest.ready) || ! wakeup_init(&ingest.room)) {
+        fprintf(stderr, "Error: cannot set up the input queue\n");
+        exit(1);
+    }
+}
+
+// Producer: make the records pushed so far visible, and wake the consumer up unless it
+// was already. Sequentially consistent, against ingest_drain(): either it sees the new
+// head, or we see that it cleared `notified`.
+static void ingest_publish(void) {
+    if (ingest.pushed == ingest.head)
+        return;
+    __atomic_store_n(&ingest.head, ingest.pushed, __ATOMIC_SEQ_CST);
+    if (! __atomic_exchange_n(&ingest.notified, true, __ATOMIC_SEQ_CST))
+        wakeup_signal(&ingest.ready);
+}
+
+// Producer: wait until the consumer makes room in the full ring.
+static void ingest_wait_for_room(void) {
+    ingest_publish();  // so that it has something to pop
+    while (true) {
+        // Sequentially consistent, against ingest_drain(): either it sees that we
+        // wait, or we see the tail it moved.
+        __atomic_store_n(&ingest.waiting, true, __ATOMIC_SEQ_CST);
+        ingest.known_tail = __atomic_load_n(&ingest.tail, __ATOMIC_SEQ_CST);
+        if (ingest.pushed - ingest.known_tail <= ingest.mask)
+            break;
+        struct pollfd room = {.fd = ingest.room.read_fd, .events = POLLIN};
+        poll(&room, 1, -1);
+        wakeup_clear(&ingest.room);
+    }
+    __atomic_store_n(&ingest.waiting, false, __ATOMIC_RELAXED);
+}
+
+// Producer: append a record. It becomes visible with the next ingest_publish().
+static void ingest_push(const struct timeval *t, double clock, const double *record) {
+    if (ingest.pushed - ingest.known_tail > ingest.mask) {  // full, when last seen
+        ingest.known_tail = __atomic_load_n(&ingest.tail, __ATOMIC_ACQUIRE);
+        if (ingest.pushed - ingest.known_tail > ingest.mask)
+            ingest_wait_for_room();
+    }
+    const size_t slot = ingest.pushed & ingest.mask;
+    ingest.times[slot] = *t;
+    ingest.clocks[slot] = clock;
+    memcpy(ingest.values + slot * series, record, series * sizeof(double));
+    ingest.pushed++;
+}
+
+// Producer: the input ended. Nothing may be pushed after this.
+static void ingest_close(char *error) {
+    ingest_publish();
+    ingest.error = error;
+    __atomic_store_n(&ingest.closed, true, __ATOMIC_RELEASE);
+    wakeup_signal(&ingest.ready);
+}
+
+// Store a record as the next column of the plot, with the envelope of each value as
+// (low, high) pairs, or NULL for just the values.
+static void store_column(long long t, const double *record, const double *range) {
+    for (int k = 0; k < series; k++)
+        window_stats_push(&stats[k], k, record[k], range ? range[2 * k] : record[k],
+                          range ? range[2 * k + 1] : record[k]);
+    memcpy(values + (v % capacity) * series, record, series * sizeof(double));
+    if (envelopes != NULL) {
+        double *slot = envelopes + (v % capacity) * series * 2;
+        for (int k = 0; k < series; k++) {
+            slot[2 * k] = range ? range[2 * k] : record[k];
+            slot[2 * k + 1] = range ? range[2 * k + 1] : record[k];
+        }
+    }
+    if (heat_counts != NULL) {
+        memcpy(heat_counts + (v % capacity) * HEAT_BINS, heat_open, sizeof(heat_open));
+        memset(heat_open, 0, sizeof(heat_open));
+    }
+    history_append(t, record);
+    v++;
+    redraw_needed = true;
+}
+
+// Records folded into the next column (-K, -T): running sums, extremes and last
+// values, so that each record costs O(1) per series whatever the aggregation.
+// Missing (NaN) values are left out, so each series counts its own values.
+static struct {
+    int count;
+    int counts[MAX_SERIES];
+    double sums[MAX_SERIES];
+    double mins[MAX_SERIES];
+    double maxes[MAX_SERIES];
+    double lasts[MAX_SERIES];
+} fold;
+
+static void fold_add(const double *record) {
+    if (heatmap != HEAT_NONE)
+        heat_add(record[0]);
+    for (int k = 0; k < series; k++) {
+        if (isnan(record[k]))
+            continue;
+        fold.sums[k] += record[k];
+        fold.mins[k] = fold.counts[k] ? fmin(fold.mins[k], record[k]) : record[k];
+        fold.maxes[k] = fold.counts[k] ? fmax(fold.maxes[k], record[k]) : record[k];
+        fold.lasts[k] = record[k];
+        fold.counts[k]++;
     }
+    fold.count++;
+}
 
-    if (colors[TEXT_COLOR] != -1)
-        attroff(COLOR_PAIR(TEXT_COLOR + 1));
+// Store the folded records as a column, with a gap for each series without values,
+// and start over.
+static void fold_store(long long t) {
+    double record[MAX_SERIES], range[2 * MAX_SERIES];
+    for (int k = 0; k < series; k++) {
+        const int n = fold.counts[k];
+        const double avg = n ? fold.sums[k] / n : NAN;
+        const double min = n ? fold.mins[k] : NAN;
+        const double max = n ? fold.maxes[k] : NAN;
+        switch (aggregation) {
+            case AGGREGATE_MIN:
+                record[k] = min;
+                break;
+            case AGGREGATE_MAX:
+                record[k] = max;
+                break;
+            case AGGREGATE_LAST:
+                record[k] = n ? fold.lasts[k] : NAN;
+                break;
+            default:
+                record[k] = avg;
+        }
+        range[2 * k] = min;
+        range[2 * k + 1] = max;
+    }
+    store_column(t, record, (aggregation == AGGREGATE_ENVELOPE) ? range : NULL);
+    memset(fold.sums, 0, sizeof(fold.sums));
+    memset(fold.counts, 0, sizeof(fold.counts));
+    fold.count = 0;
+}
 
-    if (braille)
-        plot_dots(plotheight, plotwidth, values1, two ? values2 : NULL, max, min, n, 4,
-                  braille_bits, NULL);
-    else if (block)
-        plot_dots(plotheight, plotwidth, values1, two ? values2 : NULL, max, min, n, 2,
-                  quad_bits, quad_glyphs);
-#ifdef AALIB
-    else if (aa)
-        plot_aa(plotheight, plotwidth, values1, two ? values2 : NULL, max, min, n);
-#endif
-    else
-        plot_values(plotheight, plotwidth, values1, two ? values2 : NULL, max, min, n,
-                    &plotchar, &max_errchar, &min_errchar, hardmax, hardmin);
+// Time-based X axis (-T): each column covers an interval of wall-clock time, aligned
+// on multiples of it since the epoch, and shows the records received during it,
+// aggregated as per -a, or a gap if there were none. A column is stored once its
+// interval is over, so that input at any rate costs at most one column per interval
+// to draw. The axis starts with the first record and stops at the end of the input.
+// With -R, the time is that of the records instead: an interval is over when a
+// record comes from a later one, as the wall clock says nothing about theirs.
+static long long bucket = -1;       // interval of the column being filled, -1 = none
+static double bucket_deadline = 0;  // monotonic time at which it is over
+
+static long long bucket_of(const struct timeval *t) {
+    return (long long)floor((t->tv_sec + 1e-6 * t->tv_usec) / bucket_interval);
+}
 
-    draw_axes(height, plotheight, plotwidth, max, min, unit);
+static void arm_bucket_deadline(void) {
+    struct timeval t;
+    gettimeofday(&t, NULL);
+    const double left = (bucket + 1) * bucket_interval - (t.tv_sec + 1e-6 * t.tv_usec);
+    bucket_deadline = monotonic_now() + ((left > 0) ? left : 0);
+}
 
-    // Apply title color if specified
-    if (colors[TITLE_COLOR] != -1)
-        attron(COLOR_PAIR(TITLE_COLOR + 1));
+// Store the column being filled, then gaps up to the interval `until`, if that is
+// later. A long gap needs no more columns than the ring buffer holds.
+static void close_buckets(long long until) {
+    fold_store(llrint(bucket * bucket_interval * 1000));
 
-    mvaddstr(0, (width / 2) - (strlen(title) / 2), title);
+    const long long first_gap = (until - bucket - 1 > capacity) ? until - capacity
+                                                                 : bucket + 1;
+    for (long long b = first_gap; b < until; b++)
+        fold_store(llrint(b * bucket_interval * 1000));
 
-    if (colors[TITLE_COLOR] != -1)
-        attroff(COLOR_PAIR(TITLE_COLOR + 1));
+    bucket = until;
+    arm_bucket_deadline();
+}
 
-    move(0, 0);
+// Close the intervals that are over at time t.
+static void advance_buckets(const struct timeval *t) {
+    const long long b = bucket_of(t);
+    if (bucket >= 0 && b > bucket)
+        close_buckets(b);
 }
 
-// Send signals through a pipe, in order to catch them without race conditions.
-// pselect() could be an alternative, but it is unreliable on Linux.
-// (Related: https://stackoverflow.com/q/62315082)
-static void signal_handler(int signum) {
-    const unsigned char signal_number =
-        (unsigned char)signum;  // signum is either 2 (SIGINT) or 28 (SIGWINCH)
-    ssize_t write_res;
-    int saved_errno = errno;
-    do {
-        write_res = write(signal_write_fd, &signal_number, 1);
-    } while ((write_res == -1) && (errno == EINTR));
-    errno = saved_errno;
+// Fold a record into the column of the interval it was received in. One read late,
+// after its interval was closed, joins the current column.
+static void fold_record(const struct timeval *t, const double *record) {
+    if (bucket < 0) {
+        bucket = bucket_of(t);
+        arm_bucket_deadline();
+    }
+    advance_buckets(t);
+    fold_add(record);
 }
 
-static void redraw_screen(const char *errstr) {
-    if (window_big_enough_to_draw()) {
-        paint_plot();
+// Store a full record: the last step of the input, done by the main thread.
+static void store_record(const struct timeval *t, double clock, double *record) {
+    if (rate) {
+        const double dt = derivative(record, clock);
+        if (! isnan(dt))
+            td = dt;
+    }
+    for (int k = 0; percentiles == PERCENTILES_SESSION && k < series; k++) {
+        quantiles_add(&session_quantiles[k], record[k], 1);
+        if (record[k] < session_mins[k])
+            session_mins[k] = record[k];
+        if (record[k] > session_maxes[k])
+            session_maxes[k] = record[k];
+    }
 
-        if (errstr != NULL) {
-            show_all_centered(errstr);
-        } else if (v < 1) {
-            show_all_centered("waiting for data from stdin");
-        }
+    if (bucket_interval > 0) {
+        fold_record(t, record);
+    } else if (fold_size > 1) {
+        fold_add(record);
+        if (fold.count == fold_size)
+            fold_store(t->tv_sec * 1000LL + t->tv_usec / 1000);
     } else {
-        show_window_size_error();
+        if (heatmap != HEAT_NONE)
+            heat_add(record[0]);
+        store_column(t->tv_sec * 1000LL + t->tv_usec / 1000, record, NULL);
     }
-
-    refresh();
+    input_records++;
+    pending_records++;
 }
 
-// Return a pointer to the last occurrence within [s, s+n) of one of the bytes in the
-// string accept.
-static char *find_last(char *s, size_t n, const char *accept) {
-    for (int pos = n - 1; pos >= 0; pos--) {
-        if (strchr(accept, s[pos]))
-            return s + pos;
+// Consumer: store all the records pushed so far.
+// Return whether the input ended, after setting errstr to tell why.
+static bool ingest_drain(void) {
+    wakeup_clear(&ingest.ready);
+    __atomic_store_n(&ingest.notified, false, __ATOMIC_SEQ_CST);
+    const bool closed = __atomic_load_n(&ingest.closed, __ATOMIC_ACQUIRE);
+    const size_t head = __atomic_load_n(&ingest.head, __ATOMIC_SEQ_CST);
+
+    for (size_t i = ingest.tail; i != head; i++) {
+        const size_t slot = i & ingest.mask;
+        store_record(&ingest.times[slot], ingest.clocks[slot],
+                     ingest.values + slot * series);
+    }
+    __atomic_store_n(&ingest.tail, head, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&ingest.waiting, __ATOMIC_SEQ_CST))
+        wakeup_signal(&ingest.room);
+
+    if (closed) {
+        if (bucket >= 0 && fold.count > 0) {  // the end of the input ends the time axis
+            close_buckets(bucket + 1);
+        } else if (bucket < 0 && fold.count > 0) {  // and the last column of -K
+            struct timeval now;
+            gettimeofday(&now, NULL);
+            fold_store(now.tv_sec * 1000LL + now.tv_usec / 1000);
+        }
+        bucket = -1;
+        errstr = ingest.error ? ingest.error : "input stream closed";
+        redraw_needed = true;  // redraw to display the error message
     }
-    return NULL;  // not found
+    return closed;
 }
 
-// Handle a single value from the input stream.
-// Return whether we got a full data record.
-static bool handle_value(double value) {
-    static double saved_value;
-    static int saved_value_valid = 0;
-
-    // First value of a 2-value record: save it for later.
-    if (two && ! saved_value_valid) {
-        saved_value = value;
-        saved_value_valid = 1;
-        return false;
-    }
+// Handle a single value from the input stream, ending at `end` in the chunk being
+// parsed, pushing each full record. A record came when its timestamp says with -R,
+// and otherwise at the time of the read that brought it, by the monotonic clock:
+// the records of a read are spread between that read and the one before in
+// proportion to where they end in the data, delimiters after them included, so that
+// each comes later than the previous one, as it did, instead of all at once, and the
+// last one at the time of the read.
+static void handle_value(double value, const char *end) {
+    static double record[1 + MAX_SERIES];
+    static int received = 0;  // values of the record received so far
+
+    // Values before the last one of a record: save them for later.
+    record[received++] = value;
+    if (received < series + timestamps)
+        return;
 
     // Otherwise we have a full record.
-    n = (n + 1) % plotwidth;
-    if (two) {
-        values1[n] = saved_value;
-        values2[n] = value;
-        saved_value_valid = 0;
+    received = 0;
+    if (timestamps) {
+        if (isnan(record[0]))  // a record without a time cannot be placed
+            return;
+        const double seconds = floor(record[0]);
+        const suseconds_t microseconds = (suseconds_t)((record[0] - seconds) * 1e6);
+        const struct timeval t = {.tv_sec = (time_t)seconds, .tv_usec = microseconds};
+        ingest_push(&t, record[0], record + 1);
     } else {
-        values1[n] = value;
+        const char *chunk_end = chunk_start + chunk_length;
+        while (input_format == INPUT_TEXT && end < chunk_end && is_delimiter(*end))
+            end++;
+        const double done =
+            (chunk_length > 0) ? (double)(end - chunk_start) / chunk_length : 1;
+        const double elapsed = ingest_clock - previous_ingest_clock;
+        ingest_push(&ingest_time, previous_ingest_clock + elapsed * done, record);
     }
-    if (rate)
-        td = derivative(&values1[n], two ? &values2[n] : NULL, &now);
-    return true;
 }
 
-// Handle a chunk of input data: extract the numbers, store them, redraw if needed.
+// Little-endian loads from the input buffer. Compilers turn these into plain loads.
+static uint32_t load_u32le(const char *p) {
+    const unsigned char *b = (const unsigned char *)p;
+    return (uint32_t)b[0] | (uint32_t)b[1] << 8 | (uint32_t)b[2] << 16 |
+           (uint32_t)b[3] << 24;
+}
+
+static uint64_t load_u64le(const char *p) {
+    return (uint64_t)load_u32le(p) | (uint64_t)load_u32le(p + 4) << 32;
+}
+
+// Handle a single binary sample ending at `end`. One that is not finite is stored
+// as NAN, a gap, as records have a fixed size and the next ones must stay aligned.
+// Return whether it was accepted.
+static bool handle_sample(double value, const char *end) {
+    const bool finite = isfinite(value);
+    handle_value(finite ? value : NAN, end);
+    return finite;
+}
+
+// Handle a chunk of binary input, decoding the samples in place.
+// Return the number of bytes consumed: a trailing partial sample is left for later.
+static size_t handle_binary_data(const char *buffer, size_t length) {
+    const size_t size = input_formats[input_format].size;
+    const char *end = buffer + length - length % size;
+    size_t rejected = 0;  // samples that are not finite
+    const char *p;
+
+    chunk_start = buffer;
+    chunk_length = end - buffer;
+
+    switch (input_format) {
+        case INPUT_F64LE:
+            for (p = buffer; p < end; p += size) {
+                const uint64_t bits = load_u64le(p);
+                double value;
+                memcpy(&value, &bits, sizeof(value));
+                rejected += ! handle_sample(value, p + size);
+            }
+            break;
+        case INPUT_F32LE:
+            for (p = buffer; p < end; p += size) {
+                const uint32_t bits = load_u32le(p);
+                float value;
+                memcpy(&value, &bits, sizeof(value));
+                rejected += ! handle_sample(value, p + size);
+            }
+            break;
+        case INPUT_I32LE:
+            for (p = buffer; p < end; p += size)
+                handle_sample((int32_t)load_u32le(p), p + size);
+            break;
+        case INPUT_I64LE:
+            for (p = buffer; p < end; p += size)
+                handle_sample((double)(int64_t)load_u64le(p), p + size);
+            break;
+        default:
+            break;
+    }
+    diagnostics_count(&rejected_tokens, rejected);
+    ingest_publish();
+    return end - buffer;
+}
+
+// Handle a chunk of input data: extract the numbers and push the records they make.
 // Return the number of bytes consumed.
 static size_t handle_input_data(char *buffer, size_t length) {
-    static const char delimiters[] = " \t\r\n";  // white space
+    if (input_format != INPUT_TEXT)
+        return handle_binary_data(buffer, length);
 
     // Find the last delimiter.
-    char *end = find_last(buffer, length, delimiters);
-    if (! end)
+    size_t end = length;
+    while (end > 0 && ! is_delimiter(buffer[end - 1]))
+        end--;
+    if (end == 0)
         return 0;
-    *end = '\0';
 
     // Tokenize and parse.
-    int records = 0;  // number or records found
-    char *str = buffer;
+    chunk_start = buffer;
+    chunk_length = end;
+    size_t rejected = 0;  // garbage tokens
+    struct token_scanner scanner;
     char *token;
-    while ((token = strtok(str, delimiters)) != NULL) {
-        str = NULL;  // tell strtok() to stay on the same string next time
+    size_t token_length;
+    token_scanner_init(&scanner, buffer, end);
+    while (token_scanner_next(&scanner, &token, &token_length)) {
+        double value;
+        if (parse_number(token, token_length, &value))
+            handle_value(value, token + token_length);
+        else  // garbage or not finite
+            rejected++;
+    }
+    diagnostics_count(&rejected_tokens, rejected);
+    ingest_publish();
+    return end;
+}
 
-        char *number_end;
-        double value = strtod(token, &number_end);
-        if (*number_end != '\0')  // garbage found
-            continue;
-        if (! isfinite(value))
-            continue;
-        if (handle_value(value))
-            records++;
-    }
-    v += records;
-    if (records > 0)
-        redraw_needed = true;
-    return end - buffer + 1;
-}
-
-// Handle an "input ready" event, where only a single read() is guaranteed to not block.
-// Return whether the input stream got closed.
-static bool handle_input_event(void) {
-    static char buffer[4096];
-    static size_t buffer_pos = 0;
-
-    // Buffer incoming data.
-    ssize_t bytes_read =
-        read(STDIN_FILENO, buffer + buffer_pos, sizeof(buffer) - 1 - buffer_pos);
-    if (bytes_read < 0) {                       // read error
-        if (errno == EINTR || errno == EAGAIN)  // we should try again later
-            return false;
-        errstr = strerror(errno);  // other errors are considered fatal
-        redraw_needed = true;      // redraw to display the error message
-        return true;
+// Input buffer: bytes [start, end) of data are pending. After handle_input_data() that
+// is at most one partial token, so compacting it to the front is cheap. The buffer
+// grows while reads keep filling it, up to INPUT_BUFFER_MAX; only a partial token
+// that outgrows even that is dropped, up to the next delimiter.
+#define INPUT_BUFFER_MIN (64 * 1024)
+#define INPUT_BUFFER_MAX (4 * 1024 * 1024)
+#define INPUT_PIPE_SIZE (1024 * 1024)  // requested with F_SETPIPE_SZ, best effort
+
+struct input_buffer {
+    char *data;
+    size_t size, start, end;
+    bool skipping;  // dropping the rest of an oversized token
+};
+
+static struct input_buffer input;
+static int input_fd = STDIN_FILENO;     // watched for input, -1 = poll periodically
+static bool input_nonblocking = false;  // input can be drained until EAGAIN
+static int stdin_flags = -1;            // file status flags to restore on exit
+
+// Following a file (-i) instead of reading stdin.
+#define FOLLOW_POLL_INTERVAL 0.25  // seconds, without inotify
+static long long follow_offset = 0;  // -O: from the start, or from the end if < 0
+static bool follow_offset_set = false;
+static int follow_fd = -1;
+static off_t follow_pos = 0;  // where to read next
+#ifdef __linux__
+static int inotify_fd = -1, inotify_file_watch = -1;
+#endif
+
+static void restore_stdin_flags(void) {
+    if (stdin_flags != -1)
+        fcntl(STDIN_FILENO, F_SETFL, stdin_flags);
+}
+
+// Make stdin non-blocking, so that handle_input_event() can drain it, and enlarge
+// the pipe feeding it where the system allows.
+static void setup_stdin(void) {
+#ifdef __linux__
+    struct stat st;
+    if (fstat(STDIN_FILENO, &st) == 0 && S_ISFIFO(st.st_mode))
+        fcntl(STDIN_FILENO, F_SETPIPE_SZ, INPUT_PIPE_SIZE);  // may fail: harmless
+#endif
+    stdin_flags = fcntl(STDIN_FILENO, F_GETFL);
+    if (stdin_flags == -1)
+        return;
+    if (fcntl(STDIN_FILENO, F_SETFL, stdin_flags | O_NONBLOCK) == -1) {
+        stdin_flags = -1;
+        return;
     }
-    if (bytes_read == 0) {
-        errstr = "input stream closed";
-        buffer[buffer_pos++] = '\n';  // attempt to extract one last value
-        handle_input_data(buffer, buffer_pos);
-        redraw_needed = true;  // redraw to display the error message
+    atexit(restore_stdin_flags);
+    input_nonblocking = true;
+}
+
+static void input_buffer_reset(struct input_buffer *in) {
+    in->start = in->end = 0;
+    in->skipping = false;
+}
+
+// (Re)arm the inotify watch on the followed file, after opening it.
+static void follow_watch(void) {
+#ifdef __linux__
+    if (inotify_fd == -1)
+        return;
+    if (inotify_file_watch != -1)
+        inotify_rm_watch(inotify_fd, inotify_file_watch);
+    inotify_file_watch = inotify_add_watch(
+        inotify_fd, follow_path, IN_MODIFY | IN_ATTRIB | IN_MOVE_SELF | IN_DELETE_SELF);
+#endif
+}
+
+// Open the file to follow and seek to where reading starts: its end by default, so
+// that only new data is plotted. Appends are waited for with inotify on Linux (its
+// directory is watched too, to notice rotation), by polling elsewhere.
+static void setup_follow(void) {
+    struct stat st;
+    follow_fd = open(follow_path, O_RDONLY);
+    if (follow_fd == -1 || fstat(follow_fd, &st) != 0) {
+        fprintf(stderr, "Error: cannot open %s: %s\n", follow_path, strerror(errno));
+        exit(1);
+    }
+
+    long long pos = st.st_size;
+    if (follow_offset_set)
+        pos = (follow_offset < 0) ? st.st_size + follow_offset : follow_offset;
+    if (pos < 0)
+        pos = 0;
+    if (pos > st.st_size)
+        pos = st.st_size;
+    if (input_format != INPUT_TEXT) {  // start on a record boundary
+        const long long record_size = input_formats[input_format].size * series;
+        pos -= pos % record_size;
+    } else if (pos > 0) {  // do not start in the middle of a token
+        char previous;
+        if (pread(follow_fd, &previous, 1, pos - 1) == 1 && ! is_delimiter(previous))
+            input.skipping = true;
+    }
+    follow_pos = pos;
+    input_nonblocking = true;  // reads report EAGAIN once caught up
+    input_fd = -1;
+
+#ifdef __linux__
+    inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd == -1)
+        return;
+    const char *slash = strrchr(follow_path, '/');
+    char directory[4096] = ".";
+    if (slash == follow_path)
+        strcpy(directory, "/");
+    else if (slash != NULL && slash - follow_path < (long)sizeof(directory))
+        snprintf(directory, sizeof(directory), "%.*s", (int)(slash - follow_path),
+                 follow_path);
+    follow_watch();
+    if (inotify_file_watch == -1 ||
+        inotify_add_watch(inotify_fd, directory, IN_CREATE | IN_MOVED_TO) == -1) {
+        close(inotify_fd);  // poll instead
+        inotify_fd = -1;
+        return;
+    }
+    input_fd = inotify_fd;
+#endif
+}
+
+// Called once the followed file has no more data for us: notice if it was truncated
+// (copytruncate) or if the path now names a new file (rotation), and restart reading
+// from the beginning. Return whether there may be new data.
+static bool follow_check(void) {
+    struct stat st, path_st;
+    if (fstat(follow_fd, &st) != 0)
+        return false;
+    if (st.st_size < follow_pos) {
+        follow_pos = 0;
+        input_buffer_reset(&input);
         return true;
     }
+    if (stat(follow_path, &path_st) != 0 ||
+        (path_st.st_dev == st.st_dev && path_st.st_ino == st.st_ino))
+        return false;  // gone for now, or still the same file
+    const int fd = open(follow_path, O_RDONLY);
+    if (fd == -1)
+        return false;
+    close(follow_fd);
+    follow_fd = fd;
+    follow_pos = 0;
+    input_buffer_reset(&input);
+    follow_watch();
+    return true;
+}
+
+// Read input from stdin, or from the followed file where we left off.
+// Either way, fail with EAGAIN once there is nothing new to read.
+static ssize_t read_input(char *buffer, size_t count) {
+    if (follow_fd == -1)
+        return read(STDIN_FILENO, buffer, count);
+
+    const ssize_t bytes_read = pread(follow_fd, buffer, count, follow_pos);
+    if (bytes_read > 0)
+        follow_pos += bytes_read;
+    if (bytes_read != 0)
+        return bytes_read;
+    errno = EAGAIN;  // a followed file never ends
+    return -1;
+}
+
+// Discard pending inotify events: what changed is found out by reading.
+static void drain_inotify(void) {
+#ifdef __linux__
+    char events[4096];
+    while (inotify_fd != -1 && read(inotify_fd, events, sizeof(events)) > 0)
+        continue;
+#endif
+}
+
+// Close the input, stdin or the followed file, once it failed or ended.
+static void close_input(void) {
+    if (follow_fd == -1) {
+        restore_stdin_flags();
+        close(STDIN_FILENO);
+        return;
+    }
+    close(follow_fd);
+#ifdef __linux__
+    if (inotify_fd != -1)
+        close(inotify_fd);
+#endif
+}
 
-    // The data we read could contain null bytes, so we replace those
-    // by one of the supported delimiters to not lose all input coming after.
-    for (size_t i = buffer_pos; i < buffer_pos + bytes_read; i++) {
-        if (buffer[i] == '\0') {
-            buffer[i] = ' ';
+// Make room for reading at least a quarter of the buffer.
+static void input_buffer_make_room(struct input_buffer *in, bool grow) {
+    if (in->data == NULL || (grow && in->size < INPUT_BUFFER_MAX)) {
+        const size_t size = in->data ? in->size * 2 : INPUT_BUFFER_MIN;
+        char *data = realloc(in->data, size);
+        if (data == NULL) {
+            if (in->data == NULL) {
+                endwin();
+                fprintf(stderr, "Error: cannot allocate the input buffer\n");
+                exit(1);
+            }
+        } else {
+            in->data = data;
+            in->size = size;
         }
     }
+    if (in->size - 1 - in->end >= in->size / 4)
+        return;
+    if (in->start > 0) {
+        memmove(in->data, in->data + in->start, in->end - in->start);
+        in->end -= in->start;
+        in->start = 0;
+    }
+    if (in->size - 1 - in->end >= in->size / 4)
+        return;
+    if (in->size < INPUT_BUFFER_MAX) {
+        input_buffer_make_room(in, true);
+    } else {  // a single token fills the buffer: it can only be garbage
+        diagnostics_count(&dropped_bytes, in->end - in->start);
+        in->start = in->end = 0;
+        in->skipping = true;
+    }
+}
 
-    buffer_pos += bytes_read;
+// Handle an "input ready" event: read until the input would block.
+// Return whether the input stream got closed, after setting error to tell why, or to
+// NULL at the end of the input.
+static bool handle_input_event(char **error) {
+    struct input_buffer *in = &input;
+    bool grow = false;
 
-    // Handle this new data.
-    size_t bytes_consumed = handle_input_data(buffer, buffer_pos);
+    if (follow_fd != -1)
+        drain_inotify();
+    do {
+        input_buffer_make_room(in, grow);
+
+        // Keep one byte for the final delimiter at end of input.
+        const size_t room = in->size - 1 - in->end;
+        ssize_t bytes_read = read_input(in->data + in->end, room);
+        if (bytes_read < 0) {  // read error
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {  // drained
+                if (follow_fd != -1 && follow_check())
+                    continue;
+                return false;
+            }
+            *error = strerror(errno);  // other errors are considered fatal
+            return true;
+        }
+        gettimeofday(&ingest_time, NULL);
+        previous_ingest_clock = ingest_clock;
+        ingest_clock = monotonic_now();
+        diagnostics_count(&input_bytes, bytes_read);
+        if (bytes_read == 0) {
+            *error = NULL;  // the end, not an error
+            if (input_format == INPUT_TEXT && ! in->skipping) {
+                in->data[in->end++] = '\n';  // attempt to extract one last value
+                handle_input_data(in->data + in->start, in->end - in->start);
+            }  // a partial binary sample is dropped
+            in->start = in->end = 0;
+            return true;
+        }
+        grow = ((size_t)bytes_read == room);  // more is likely waiting
+
+        // The text we read could contain null bytes, so we replace those
+        // by one of the supported delimiters to not lose all input coming after.
+        char *data = in->data + in->end;
+        for (ssize_t i = 0; input_format == INPUT_TEXT && i < bytes_read; i++) {
+            if (data[i] == '\0') {
+                data[i] = ' ';
+            }
+        }
 
-    // If we have excessive garbage, discard a bunch. This is to ensure that we can
-    // always ask read for >= 1K bytes, and keep good performance, especially with high
-    // input pressure.
-    if (buffer_pos - bytes_consumed > sizeof(buffer) / 2)
-        bytes_consumed += sizeof(buffer) / 4;
+        // Skip what is left of an oversized token.
+        if (in->skipping) {
+            ssize_t i = 0;
+            while (i < bytes_read && ! is_delimiter(data[i]))
+                i++;
+            diagnostics_count(&dropped_bytes, i);
+            if (i == bytes_read)
+                continue;
+            in->skipping = false;
+            in->start = in->end + i;
+        }
+        in->end += bytes_read;
 
-    if (bytes_consumed > 0 && bytes_consumed < buffer_pos)
-        memmove(buffer, buffer + bytes_consumed, buffer_pos - bytes_consumed);
-    buffer_pos -= bytes_consumed;
+        // Handle this new data.
+        in->start += handle_input_data(in->data + in->start, in->end - in->start);
+        if (in->start == in->end)
+            in->start = in->end = 0;
+    } while (input_nonblocking);
     return false;
 }
 
+// Wait until the input may have more data: stdin or the inotify instance polls
+// readable, or it is time to check the followed file again without inotify.
+static void wait_for_input(void) {
+    struct pollfd input_ready = {.fd = input_fd, .events = POLLIN};  // -1: ignored
+    poll(&input_ready, 1, (input_fd != -1) ? -1 : (int)(FOLLOW_POLL_INTERVAL * 1000));
+}
+
+// The input thread: read and parse the input until it ends.
+static void *ingest_main(void *unused) {
+    (void)unused;
+    sigset_t signals;  // they are for the main thread
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGWINCH);
+    pthread_sigmask(SIG_BLOCK, &signals, NULL);
+
+    char *error = NULL;
+    while (! handle_input_event(&error))
+        wait_for_input();
+    close_input();
+    ingest_close(error);
+    return NULL;
+}
+
 // Refresh the clock on the next full second (plus a few milliseconds).
 //
 // We will sleep for a duration of up to a full second here knowing that:
@@ -1018,24 +3462,34 @@ static struct timeval calculate_clock_refresh_timeout_from(suseconds_t now_tv_us
         .tv_usec = microseconds_remaining % microseconds_per_second};
 }
 
-// Block until (a) we receive a signal or (b) stdin can be read without blocking
-// or (c) timeout expires, in order to reduce use of CPU and power while idle
+// Time left until the next frame may be painted, given monotonic timestamps.
+// Input arriving faster than the frame rate is coalesced until this expires.
+static struct timeval calculate_frame_timeout_from(double now, double next_frame) {
+    const double remaining = (next_frame > now) ? next_frame - now : 0;
+    const long microseconds_remaining = (long)(remaining * 1e6);
+    return (struct timeval){.tv_sec = microseconds_remaining / 1000000,
+                            .tv_usec = microseconds_remaining % 1000000};
+}
+
+// Block until (a) we receive a signal or (b) the input thread pushed records
+// or (c) timeout expires, in order to reduce use of CPU and power while idle.
+// If frame_deadline is not NULL (a repaint is pending), it caps the timeout.
 //
 // Returns one of:
 //   A) EVENT_TIMEOUT
 //   B) EVENT_UNKNOWN
 //   C) One or more of EVENT_*_READABLE or'ed together
 //
-static int wait_for_events(int signal_read_fd, int tty, bool stdin_is_open,
-                           struct timeval *timeout) {
+static int wait_for_events_select(int tty, bool stdin_is_open,
+                                  const double *frame_deadline) {
     fd_set read_fds;
     FD_ZERO(&read_fds);
     FD_SET(signal_read_fd, &read_fds);
     int select_nfds = signal_read_fd + 1;
     if (stdin_is_open) {
-        FD_SET(STDIN_FILENO, &read_fds);
-        if (STDIN_FILENO >= select_nfds)
-            select_nfds = STDIN_FILENO + 1;
+        FD_SET(ingest.ready.read_fd, &read_fds);
+        if (ingest.ready.read_fd >= select_nfds)
+            select_nfds = ingest.ready.read_fd + 1;
     }
     if (tty != -1) {
         FD_SET(tty, &read_fds);
@@ -1043,7 +3497,17 @@ static int wait_for_events(int signal_read_fd, int tty, bool stdin_is_open,
             select_nfds = tty + 1;
     }
 
-    const int select_ret = select(select_nfds, &read_fds, NULL, NULL, timeout);
+    struct timeval timeout = calculate_clock_refresh_timeout_from(now.tv_usec);
+    if (frame_deadline != NULL) {
+        struct timeval frame_timeout =
+            calculate_frame_timeout_from(monotonic_now(), *frame_deadline);
+        if (frame_timeout.tv_sec < timeout.tv_sec ||
+            (frame_timeout.tv_sec == timeout.tv_sec &&
+             frame_timeout.tv_usec < timeout.tv_usec))
+            timeout = frame_timeout;
+    }
+
+    const int select_ret = select(select_nfds, &read_fds, NULL, NULL, &timeout);
 
     if (select_ret == 0) {
         return EVENT_TIMEOUT;
@@ -1060,7 +3524,7 @@ static int wait_for_events(int signal_read_fd, int tty, bool stdin_is_open,
             ret |= EVENT_TTY_READABLE;
         }
 
-        if (FD_ISSET(STDIN_FILENO, &read_fds)) {
+        if (stdin_is_open && FD_ISSET(ingest.ready.read_fd, &read_fds)) {
             ret |= EVENT_STDIN_READABLE;
         }
 
@@ -1072,21 +3536,175 @@ static int wait_for_events(int signal_read_fd, int tty, bool stdin_is_open,
     return EVENT_UNKNOWN;
 }
 
+#ifdef __linux__
+// On Linux, a single epoll instance watches the input queue, the tty, a signalfd for
+// SIGINT and SIGWINCH, and timerfds for the clock and the frame deadline, so that
+// nothing is rebuilt or recomputed per wakeup. If any of these is unavailable, we fall
+// back to the self-pipe and select() above, which is all other systems get.
+static int epoll_fd = -1, clock_timer_fd = -1, frame_timer_fd = -1;
+
+static bool epoll_watch(int fd) {
+    struct epoll_event event = {.events = EPOLLIN, .data.fd = fd};
+    return epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) == 0;
+}
+
+static bool setup_epoll(int tty) {
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGWINCH);
+
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    clock_timer_fd = timerfd_create(CLOCK_REALTIME, TFD_NONBLOCK | TFD_CLOEXEC);
+    frame_timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    signal_read_fd = -1;
+    if (epoll_fd != -1 && clock_timer_fd != -1 && frame_timer_fd != -1 &&
+        sigprocmask(SIG_BLOCK, &signals, NULL) == 0) {
+        signal_read_fd = signalfd(-1, &signals, SFD_NONBLOCK | SFD_CLOEXEC);
+        if (signal_read_fd == -1)
+            sigprocmask(SIG_UNBLOCK, &signals, NULL);
+    }
+
+    // Tick on every full second, like calculate_clock_refresh_timeout_from().
+    struct timespec t;
+    clock_gettime(CLOCK_REALTIME, &t);
+    const struct itimerspec clock_ticks = {.it_interval = {.tv_sec = 1},
+                                           .it_value = {.tv_sec = t.tv_sec + 1}};
+
+    if (signal_read_fd == -1 ||
+        timerfd_settime(clock_timer_fd, TFD_TIMER_ABSTIME, &clock_ticks, NULL) != 0 ||
+        ! epoll_watch(signal_read_fd) || ! epoll_watch(clock_timer_fd) ||
+        ! epoll_watch(frame_timer_fd) || ! epoll_watch(ingest.ready.read_fd) ||
+        (tty != -1 && ! epoll_watch(tty))) {
+        if (signal_read_fd != -1) {
+            sigprocmask(SIG_UNBLOCK, &signals, NULL);
+            close(signal_read_fd);
+        }
+        if (epoll_fd != -1)
+            close(epoll_fd);
+        if (clock_timer_fd != -1)
+            close(clock_timer_fd);
+        if (frame_timer_fd != -1)
+            close(frame_timer_fd);
+        epoll_fd = clock_timer_fd = frame_timer_fd = -1;
+        return false;
+    }
+    return true;
+}
+
+// Same contract as wait_for_events_select(). The input queue is watched until
+// stop_watching() is called on it.
+static int wait_for_events_epoll(const double *frame_deadline) {
+    static double armed_deadline = -1;  // -1: the frame timer is disarmed
+
+    // Only touch the frame timer when the deadline changes.
+    const double deadline = frame_deadline ? *frame_deadline : -1;
+    if (deadline != armed_deadline) {
+        struct itimerspec frame_timer = {{0, 0}, {0, 0}};
+        if (deadline >= 0) {
+            // Round up, so that the timer never fires before the deadline.
+            const double seconds = floor(deadline);
+            frame_timer.it_value.tv_sec = (time_t)seconds;
+            frame_timer.it_value.tv_nsec = (long)ceil((deadline - seconds) * 1e9);
+            if (frame_timer.it_value.tv_nsec >= 1000000000) {
+                frame_timer.it_value.tv_sec++;
+                frame_timer.it_value.tv_nsec -= 1000000000;
+            }
+            if (frame_timer.it_value.tv_sec == 0 && frame_timer.it_value.tv_nsec == 0)
+                frame_timer.it_value.tv_nsec = 1;  // zero would disarm
+        }
+        timerfd_settime(frame_timer_fd, TFD_TIMER_ABSTIME, &frame_timer, NULL);
+        armed_deadline = deadline;
+    }
+
+    struct epoll_event events[5];
+    const int count = epoll_wait(epoll_fd, events, 5, -1);
+    if (count < 0)
+        return EVENT_UNKNOWN;
+
+    int ret = 0;
+    for (int i = 0; i < count; i++) {
+        const int fd = events[i].data.fd;
+        if (fd == signal_read_fd) {
+            ret |= EVENT_SIGNAL_READABLE;
+        } else if (fd == ingest.ready.read_fd) {
+            ret |= EVENT_STDIN_READABLE;
+        } else if (fd == clock_timer_fd || fd == frame_timer_fd) {
+            uint64_t expirations;
+            if (read(fd, &expirations, sizeof(expirations)) < 0)
+                continue;
+            if (fd == frame_timer_fd)
+                armed_deadline = -1;  // one-shot: it is disarmed now
+        } else {
+            ret |= EVENT_TTY_READABLE;
+        }
+    }
+    return ret ? ret : EVENT_TIMEOUT;
+}
+#endif
+
+// Set up signal delivery, and everything wait_for_events() watches.
+static void setup_events(int tty) {
+#ifdef __linux__
+    if (setup_epoll(tty))
+        return;
+#else
+    (void)tty;
+#endif
+    int signal_fds[2];
+    if (pipe(signal_fds) != 0) {
+        perror("pipe");
+        exit(1);
+    }
+    signal_read_fd = signal_fds[0];
+    signal_write_fd = signal_fds[1];
+
+    signal(SIGWINCH, signal_handler);
+    signal(SIGINT, signal_handler);
+}
+
+static int wait_for_events(int tty, bool stdin_is_open, const double *frame_deadline) {
+#ifdef __linux__
+    if (epoll_fd != -1)
+        return wait_for_events_epoll(frame_deadline);
+#endif
+    return wait_for_events_select(tty, stdin_is_open, frame_deadline);
+}
+
+// Stop watching fd, which is about to be closed.
+static void stop_watching(int fd) {
+#ifdef __linux__
+    if (epoll_fd != -1)
+        epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+#else
+    (void)fd;
+#endif
+}
+
+// Return the number of a signal caught, or 0 if none is pending.
+static int read_signal(void) {
+#ifdef __linux__
+    if (epoll_fd != -1) {
+        struct signalfd_siginfo info;
+        if (read(signal_read_fd, &info, sizeof(info)) != sizeof(info))
+            return 0;
+        return info.ssi_signo;
+    }
+#endif
+    unsigned char signal_number;
+    if (read(signal_read_fd, &signal_number, 1) != 1)
+        return 0;
+    return signal_number;
+}
+
 int main(int argc, char *argv[]) {
-    int i;
     bool stdin_is_open = true;
     int cached_opterr;
-    const char *optstring = "2bBf" AA_OPT "rc:e:E:s:S:m:M:t:u:vhC:";
+    const char *optstring =
+        "2bBf" AA_OPT "rRc:e:E:s:S:m:M:N:t:u:vha:C:Dd:F:H:I:i:K:O:o:P:T:w:Z:";
     int show_ver;
     int show_usage;
 
-    // Initialize values to NAN, rather than 0, so that we know when not to
-    // draw them
-    for (i = 0; i < (int)(sizeof(values1) / sizeof(*values1)); i++) {
-        values1[i] = NAN;
-        values2[i] = NAN;
-    }
-
     // To make UI testing more robust, we display a clock that is frozen at
     // "Thu Jan  1 00:00:00 1970" when variable FAKETIME is set
     fake_clock = (getenv("FAKETIME") != NULL);
@@ -1146,8 +3764,18 @@ int main(int argc, char *argv[]) {
             case 'r':
                 rate = 1;
                 break;
+            case 'R':
+                timestamps = true;
+                break;
             case '2':
-                two = 1;
+                series = 2;
+                break;
+            case 'N':
+                series = atoi(optarg);
+                if (series < 1)
+                    series = 1;
+                if (series > MAX_SERIES)
+                    series = MAX_SERIES;
                 break;
             case 'b':
                 braille = 1;
@@ -1219,11 +3847,120 @@ int main(int argc, char *argv[]) {
             case 'u':
                 snprintf(unit, sizeof(unit), "%s", optarg);
                 break;
+            case 'D':
+                show_diagnostics = true;
+                break;
+            case 'F':
+                fps = atoi(optarg);
+                if (fps < 0)
+                    fps = 0;
+                show_frame_records = true;
+                break;
+            case 'H':
+                history = atoi(optarg);
+                if (history < 1)
+                    history = 1;
+                break;
+            case 'a': {
+                int i = AGGREGATE_AVG;
+                while (i <= AGGREGATE_ENVELOPE &&
+                       strcmp(optarg, aggregation_names[i]) != 0)
+                    i++;
+                if (i > AGGREGATE_ENVELOPE) {
+                    fprintf(stderr, "Error: unknown aggregation \"%s\"\n", optarg);
+                    exit(1);
+                }
+                aggregation = i;
+                break;
+            }
+            case 'd': {
+                int i = HEAT_LINEAR;
+                while (i <= HEAT_LOG && strcmp(optarg, heat_scale_names[i]) != 0)
+                    i++;
+                if (i > HEAT_LOG) {
+                    fprintf(stderr, "Error: unknown heatmap scale \"%s\"\n", optarg);
+                    exit(1);
+                }
+                heatmap = i;
+                break;
+            }
+            case 'P': {
+                int i = PERCENTILES_NONE;
+                while (i <= PERCENTILES_SESSION &&
+                       strcmp(optarg, percentiles_names[i]) != 0)
+                    i++;
+                if (i > PERCENTILES_SESSION) {
+                    fprintf(stderr, "Error: unknown percentiles \"%s\"\n", optarg);
+                    exit(1);
+                }
+                percentiles = i;
+                break;
+            }
+            case 'I': {
+                int i = INPUT_TEXT;
+                while (i <= INPUT_I64LE && strcmp(optarg, input_formats[i].name) != 0)
+                    i++;
+                if (i > INPUT_I64LE) {
+                    fprintf(stderr, "Error: unknown input format \"%s\"\n", optarg);
+                    exit(1);
+                }
+                input_format = i;
+                break;
+            }
+            case 'i':
+                follow_path = optarg;
+                break;
+            case 'K':
+                fold_size = atoi(optarg);
+                if (fold_size < 1)
+                    fold_size = 1;
+                break;
+            case 'O':
+                follow_offset = atoll(optarg);
+                follow_offset_set = true;
+                break;
+            case 'o':
+                snapshot_path = optarg;
+                break;
+            case 'T':
+                bucket_interval = atof(optarg);
+                if (bucket_interval < 0)
+                    bucket_interval = 0;
+                break;
+            case 'w':
+                snapshot_interval = atof(optarg);
+                if (snapshot_interval < 0)
+                    snapshot_interval = 0;
+                break;
+            case 'Z':
+                history_budget = atoi(optarg);
+                if (history_budget < 0)
+                    history_budget = 0;
+                break;
         }
     }
 
     opterr = cached_opterr;
 
+    // The scale of the heatmap covers the samples in view, not just their averages.
+    if (heatmap != HEAT_NONE)
+        aggregation = AGGREGATE_ENVELOPE;
+
+    history_max_blocks = history_budget * 1024LL / sizeof(struct history_block);
+    if (history_max_blocks > 0)
+        history_blocks = calloc(history_max_blocks, sizeof(*history_blocks));
+    if (history_blocks == NULL)
+        history_max_blocks = 0;
+    resize_values(history);
+    for (int k = 0; k < series; k++)
+        window_stats_rebuild(&stats[k], k, plotwidth);
+    for (int k = 0; percentiles == PERCENTILES_SESSION && k < series; k++) {
+        quantiles_reset(&session_quantiles[k]);
+        session_mins[k] = FLT_MAX;
+        session_maxes[k] = -FLT_MAX;
+    }
+    ingest_setup();
+
     if (softmax <= hardmin)
         softmax = hardmin + 1;
     if (hardmax <= hardmin)
@@ -1233,13 +3970,25 @@ int main(int argc, char *argv[]) {
     if (MB_CUR_MAX <= 1)
         braille = block = 0;
 
-    if (initscr() == NULL) {
+    if (follow_path != NULL)
+        setup_follow();
+
+    if (snapshot_path != NULL) {
+        setup_headless();
+    } else if (initscr() == NULL) {
         fprintf(stderr, "Error: failed to initialize ncurses\n");
         exit(1);
+    } else {
+        setup_sync();
+        setup_output_counter();
     }
 
 #ifdef __OpenBSD__
-    if (pledge("stdio tty", NULL) == -1)
+    // Following a file needs to reopen it after rotation; snapshots replace a file.
+    const char *promises = snapshot_path ? "stdio rpath wpath cpath"
+                           : follow_path ? "stdio rpath tty"
+                                         : "stdio tty";
+    if (pledge(promises, NULL) == -1)
         err(1, "pledge");
 #endif
 
@@ -1252,7 +4001,7 @@ int main(int argc, char *argv[]) {
         }
     }
 
-    if (has_colors || braille || block || aa) {
+    if (has_colors || braille || block || aa || heatmap != HEAT_NONE) {
         start_color();
         use_default_colors();
 
@@ -1278,21 +4027,36 @@ int main(int argc, char *argv[]) {
                                          : C_BLUE;
             init_pair(PAIR_BR1, br1, -1);
             init_pair(PAIR_BR2, br2, -1);
+            // Further series cycle through the colors the first two do not use.
+            for (int k = 2, color = C_BLACK; k < series; k++) {
+                do
+                    color = color % C_WHITE + 1;
+                while (color == br1 || color == br2);
+                init_pair(PAIR_BR1 + k, color, -1);
+            }
         }
+
+        // The heatmap takes the pairs of the series for its levels.
+        for (int l = 0; heatmap != HEAT_NONE && l < HEAT_LEVELS; l++)
+            init_pair(PAIR_BR1 + l, heat_palette[l], -1);
     }
 
     gettimeofday(&now, NULL);
     noecho();
     curs_set(FALSE);
     erase();
-    refresh();
     getmaxyx(stdscr, height, width);
+    if (snapshot_path == NULL) {
+        refresh();
+        redraw_screen(errstr);
+    }
 
-    redraw_screen(errstr);
-
-    // If stdin is redirected, open the terminal for reading user's keystrokes.
+    // If stdin is redirected or not read, open the terminal for user's keystrokes,
+    // unless there is no terminal to speak of (headless mode).
     int tty = -1;
-    if (! isatty(STDIN_FILENO))
+    if (follow_path == NULL && ! isatty(STDIN_FILENO))
+        setup_stdin();
+    if (snapshot_path == NULL && (follow_path != NULL || ! isatty(STDIN_FILENO)))
         tty = open("/dev/tty", O_RDONLY);
     if (tty != -1) {
         // Disable input line buffering. The function below works even when stdin
@@ -1300,37 +4064,45 @@ int main(int argc, char *argv[]) {
         cbreak();
     }
 
-    int signal_fds[2];
-    if (pipe(signal_fds) != 0) {
-        perror("pipe");
+    setup_events(tty);
+    pthread_t ingest_thread;
+    if (pthread_create(&ingest_thread, NULL, ingest_main, NULL) != 0) {
+        endwin();
+        fprintf(stderr, "Error: cannot start the input thread\n");
         exit(1);
     }
-    signal_read_fd = signal_fds[0];
-    signal_write_fd = signal_fds[1];
 
-    signal(SIGWINCH, signal_handler);
-    signal(SIGINT, signal_handler);
+    double next_frame = 0;  // monotonic time from which the next frame may be painted
+    double next_snapshot = monotonic_now() + snapshot_interval;  // headless mode
 
     while (1) {
-        struct timeval timeout = calculate_clock_refresh_timeout_from(now.tv_usec);
-
-        const int events =
-            wait_for_events(signal_read_fd, tty, stdin_is_open, &timeout);
+        const double *deadline = (snapshot_path != NULL)
+                                     ? ((snapshot_interval > 0) ? &next_snapshot : NULL)
+                                 : redraw_needed ? &next_frame
+                                                 : NULL;
+        if (bucket >= 0 && ! timestamps &&
+            (deadline == NULL || bucket_deadline < *deadline))
+            deadline = &bucket_deadline;  // -T: the column being filled is over then
+        const int events = wait_for_events(tty, stdin_is_open, deadline);
 
         // Refresh the clock if the seconds have changed.
         const time_t displayed_time = now.tv_sec;
         gettimeofday(&now, NULL);
         if (now.tv_sec != displayed_time)
             redraw_needed = true;
+        if (bucket >= 0 && ! timestamps) {
+            advance_buckets(&now);
+            if (bucket_deadline <= monotonic_now())  // the wall clock was set back
+                arm_bucket_deadline();
+        }
 
         // Handle signals.
         if (events & EVENT_SIGNAL_READABLE) {
-            unsigned char signal_number;
-            const ssize_t count = read(signal_read_fd, &signal_number, 1);
-            if (count > 0) {
+            const int signal_number = read_signal();
+            if (signal_number != 0) {
                 if (signal_number == SIGINT)
                     break;
-                if (signal_number == SIGWINCH) {
+                if (signal_number == SIGWINCH && snapshot_path == NULL) {
                     endwin();
                     initscr();
                     erase();
@@ -1348,34 +4120,62 @@ int main(int argc, char *argv[]) {
             if (count == 1) {    // we did catch a keystroke
                 if (key == 'r')  // 'r' = toggle rate mode
                     rate = ! rate;
-                else if (key == 'q')  // 'q' = quit
+                else if (key == 'd') {  // 'd' = toggle the diagnostics overlay
+                    show_diagnostics = ! show_diagnostics;
+                    redraw_needed = true;
+                } else if (key == 'q')  // 'q' = quit
                     break;
                 else if (key == '\f' || key == 12) {  // Ctrl+L = full screen refresh
                     clear();
                     redraw_needed = true;
                 }
             } else if (count == 0) {
+                stop_watching(tty);
                 close(tty);
                 tty = -1;
             }
         }
 
-        // Handle input data.
+        // Handle the records read by the input thread.
         if (events & EVENT_STDIN_READABLE) {
-            bool input_closed = handle_input_event();
+            bool input_closed = ingest_drain();
             if (input_closed) {
-                close(STDIN_FILENO);
+                stop_watching(ingest.ready.read_fd);
                 stdin_is_open = false;
+                if (snapshot_path != NULL) {  // headless: the final snapshot, and done
+                    if (ingest.error != NULL)
+                        fprintf(stderr, "Error: %s\n", ingest.error);
+                    break;
+                }
+            }
+        }
+
+        // Headless mode: write a snapshot when it is due, and paint nothing else.
+        if (snapshot_path != NULL) {
+            const double snapshot_time = monotonic_now();
+            if (snapshot_interval > 0 && snapshot_time >= next_snapshot) {
+                write_snapshot();
+                next_snapshot = snapshot_time + snapshot_interval;
             }
+            continue;
         }
 
-        // Refresh the screen if needed.
+        // Refresh the screen if needed, but no more than fps times per second:
+        // records arriving in between are folded into the next frame.
         if (redraw_needed) {
-            redraw_screen(errstr);
-            redraw_needed = false;
+            const double frame_time = monotonic_now();
+            if (frame_time >= next_frame) {
+                frame_records = pending_records;
+                pending_records = 0;
+                redraw_screen(errstr);
+                redraw_needed = false;
+                next_frame = frame_time + ((fps > 0) ? 1.0 / fps : 0);
+            }
         }
     }
 
+    if (snapshot_path != NULL)
+        write_snapshot();
     endwin();
     return 0;
 }